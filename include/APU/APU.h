@@ -9,6 +9,7 @@
 #include "APU/spsc.hpp"
 #include "AudioPlayer.h"
 #include "IRQ.h"
+#include "Snapshot.h"
 
 namespace sn
 {
@@ -38,10 +39,30 @@ public:
     void writeRegister(Address addr, Byte value);
     Byte readStatus();
 
+    // Whether the frame counter or the DMC may raise an IRQ, which can't be foreseen from outside
+    bool canInterrupt() const
+    {
+        return (frame_counter.mode == FrameCounter::Seq4Step && !frame_counter.interrupt_inhibit) || dmc.irqEnable;
+    }
+
+    // Averages every factor samples into one, so that fast-forwarded audio doesn't fill the queue faster than it is
+    // played. It is sped up and pitched up as a result
+    void setSampleDecimation(int factor) { sample_decimation = factor; }
+    // Whether the samples are queued for playing, off for frames that are going to be taken back
+    void setOutputEnabled(bool enabled) { output_enabled = enabled; }
+
+    // Saves or restores the channels and the frame counter, see Snapshot
+    void snapshot(Snapshot& state);
+
 private:
     FrameCounter             setup_frame_counter(IRQHandle& irq);
     bool                     divideByTwo = false;
 
+    int                      sample_decimation = 1;
+    int                      decimated_count   = 0;
+    float                    decimated_sum     = 0;
+    bool                     output_enabled    = true;
+
     spsc::RingBuffer<float>& audio_queue;
     Timer                    sampling_timer;
 };
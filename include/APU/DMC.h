@@ -3,6 +3,7 @@
 #include "APU/Divider.h"
 #include "Cartridge.h"
 #include "IRQ.h"
+#include "Snapshot.h"
 #include <functional>
 
 namespace sn
@@ -50,6 +51,12 @@ struct DMC
 
     bool has_more_samples() const { return remaining_bytes > 0; }
 
+    void snapshot(Snapshot& state)
+    {
+        state(irqEnable, loop, volume, change_enabled, change_rate, sample_begin, sample_length, remaining_bytes);
+        state(current_address, sample_buffer, shifter, remaining_bits, silenced, interrupt);
+    }
+
 private:
     // Load sample and return if it was succesfully loaded
     bool                         load_sample();
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "IRQ.h"
+#include "Snapshot.h"
 #include <functional>
 #include <vector>
 
@@ -49,5 +50,7 @@ struct FrameCounter
     void clearFrameInterrupt();
     void clock();
     void reset(Mode m, bool irq_inhibit);
+
+    void snapshot(Snapshot& state) { state(mode, counter, interrupt_inhibit, frame_interrupt); }
 };
 }
@@ -27,5 +27,12 @@ struct Noise
     void clock();
 
     Byte sample() const;
+
+    void snapshot(Snapshot& state)
+    {
+        volume.snapshot(state);
+        length_counter.snapshot(state);
+        state(divider, mode, period, shift_register);
+    }
 };
 }
@@ -41,6 +41,14 @@ struct Pulse
     void  clock();
 
     Byte  sample() const;
+
+    void  snapshot(Snapshot& state)
+    {
+        volume.snapshot(state);
+        length_counter.snapshot(state);
+        sweep.snapshot(state);
+        state(seq_idx, seq_type, sequencer, period);
+    }
 };
 
 }
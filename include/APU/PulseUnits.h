@@ -3,6 +3,7 @@
 #include "APU/Divider.h"
 #include "APU/FrameCounter.h"
 #include "Cartridge.h"
+#include "Snapshot.h"
 
 namespace sn
 {
@@ -57,6 +58,9 @@ struct Sweep : public FrameClockable
     static bool is_muted(int current, int target) { return current < 8 || target > 0x7FF; }
 
     int         calculate_target(int current) const;
+
+    // ones_complement is fixed by the channel
+    void        snapshot(Snapshot& state) { state(period, enabled, reload, negate, shift, divider); }
 };
 
 }
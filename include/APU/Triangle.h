@@ -24,6 +24,13 @@ struct Triangle
     Byte          sample() const;
 
     int           volume() const;
+
+    void          snapshot(Snapshot& state)
+    {
+        length_counter.snapshot(state);
+        linear_counter.snapshot(state);
+        state(seq_idx, sequencer, period);
+    }
 };
 
 }
@@ -6,6 +6,7 @@
 #include "APU/Constants.h"
 #include "APU/Divider.h"
 #include "APU/FrameCounter.h"
+#include "Snapshot.h"
 
 namespace sn
 {
@@ -19,6 +20,8 @@ struct LengthCounter : public FrameClockable
     void half_frame_clock() override;
     bool muted() const;
 
+    void snapshot(Snapshot& state) { state(halt, enabled, counter); }
+
     bool halt    = false;
 
     bool enabled = false;
@@ -30,6 +33,8 @@ struct LinearCounter : public FrameClockable
     void set_linear(int new_value);
     void quarter_frame_clock() override;
 
+    void snapshot(Snapshot& state) { state(reload, reloadValue, control, counter); }
+
     bool reload      = false;
     int  reloadValue = 0;
     bool control     = true;
@@ -43,6 +48,11 @@ struct Volume : public FrameClockable
 
     int           get() const;
 
+    void          snapshot(Snapshot& state)
+    {
+        state(divider, fixedVolumeOrPeriod, decayVolume, constantVolume, isLooping, shouldStart);
+    }
+
     Divider       divider { 0 };
     std::uint32_t fixedVolumeOrPeriod = max_volume;
     std::uint32_t decayVolume         = max_volume;
@@ -9,6 +9,9 @@ namespace sn
 {
 
 const std::chrono::milliseconds callback_period_ms { 120 };
+// With rate control, callbacks' worth of samples kept queued, and how much faster or slower they may be resampled
+const int                       target_buffer_rounds = 2;
+const double                    max_rate_adjustment  = 0.005;
 
 struct CallbackData
 {
@@ -17,6 +20,10 @@ struct CallbackData
     std::vector<float>       input_frames_buffer;
     bool                     mute;
     int                      remaining_buffer_rounds;
+    bool                     rate_control;
+    int                      input_sample_rate;
+    // Input rate the resampler is set to, nudged by the rate control
+    ma_uint32                resampled_rate;
 };
 
 // Receives input at a fixed sample rate from the audio queue and uses miniaudio to resample and output to audiodevice
@@ -33,13 +40,18 @@ public:
       : input_sample_rate(input_rate)
       , audio_queue(4 * input_rate *
                     (callback_period_ms.count() / 100)) // big enough to keep 4 callback's worth of samples
-      , cb_data { audio_queue, &resampler, {}, false, 1 }
+      , cb_data { audio_queue, &resampler, {}, false, 1, false, input_rate, ma_uint32(input_rate) }
     {
     }
     ~AudioPlayer();
 
     bool                    start();
     void                    mute();
+    // Keeps about target_buffer_rounds callbacks' worth of samples queued by resampling a little faster or slower,
+    // so the emulation and the device clocks can't drift apart. Set before start
+    void                    enableRateControl();
+    // Whether the queue is so far past the target that the emulation should wait for the device
+    bool                    isQueueFull();
 
     const int               input_sample_rate;
     // ONLY safe for 1 writer and 1 reader
@@ -1,9 +1,14 @@
 #ifndef CPU_H
 #define CPU_H
 #include "CPUOpcodes.h"
+#include "CPUTrace.h"
 #include "IRQ.h"
 #include "MainBus.h"
+#include "Profiler.h"
+#include "Snapshot.h"
+#include <cstdint>
 #include <list>
+#include <vector>
 
 namespace sn
 {
@@ -31,42 +36,133 @@ class CPU
 public:
     CPU(MainBus& mem);
 
-    void       step();
-    void       reset();
-    void       reset(Address start_addr);
-    void       log();
+    // Runs the next instruction or interrupt sequence as a whole
+    void          step();
+    void          reset();
+    void          reset(Address start_addr);
+    void          log();
+
+    Address       getPC() { return r_PC; }
+    // The cycle the next instruction starts on
+    std::uint64_t getCycles() { return m_cycles; }
+    void          skipOAMDMACycles();
+    void          skipDMCDMACycles();
+
+    void          nmiInterrupt();
+
+    IRQHandle&    createIRQHandler();
+    void          setIRQPulldown(int bit, bool state);
+
+    // Records every instruction to the recorder, nullptr to stop
+    void              setTraceRecorder(CPUTraceRecorder* recorder);
+    CPUTraceRecorder* getTraceRecorder() const { return m_traceRecorder; }
+    // Counts every instruction and routine in the profiler from the next reset on, nullptr to stop
+    void              setProfiler(Profiler* profiler);
+    Profiler*         getProfiler() const { return m_profiler; }
+
+    // Opt-in detection of loops that only wait, by reading memory or PPUSTATUS until an interrupt or a PPU event
+    void          setIdleLoopSkipping(bool enable);
+    // Whether the last step completed an iteration of such a loop
+    bool          isInIdleLoop() const { return m_idleLoopCycles != 0; }
+    bool          idleLoopPollsStatus() const { return m_idleLoopPollsStatus; }
+    // Whether an IRQ would be taken, that is the I flag is clear
+    bool          acceptsIRQ() const { return !(r_P & StatusI); }
+    // Credits the cycles of one more iteration if it ends by limit and no interrupt is pending, otherwise leaves
+    // the loop to run normally and returns false
+    bool          skipIdleIteration(std::uint64_t limit);
+
+    // Saves or restores the registers and everything in flight, see Snapshot
+    void          snapshot(Snapshot& state);
 
-    Address    getPC() { return r_PC; }
-    void       skipOAMDMACycles();
-    void       skipDMCDMACycles();
-
-    void       nmiInterrupt();
+private:
+    using OpcodeHandler = void (CPU::*)();
 
-    IRQHandle& createIRQHandler();
-    void       setIRQPulldown(int bit, bool state);
+    // An instruction with its handler and operand already resolved
+    struct DecodedInstruction
+    {
+        OpcodeHandler handler = nullptr; // nullptr if not decoded yet
+        Address       operand = 0;
+        Byte          opcode  = 0;
+        Byte          length  = 0;
+        Byte          cycles  = 0;
+    };
 
-private:
     void                  interruptSequence(InterruptType type);
 
+    // Where and in which state a backward jump left the CPU
+    struct LoopState
+    {
+        Address       pc;
+        Address       target;
+        Byte          a, x, y, sp, p;
+        std::uint32_t registerReads;
+
+        bool          operator==(const LoopState& other) const
+        {
+            return pc == other.pc && target == other.target && a == other.a && x == other.x && y == other.y &&
+                   sp == other.sp && p == other.p && registerReads == other.registerReads;
+        }
+    };
+
+    CPUTraceRecord        makeTraceRecord(const DecodedInstruction& instruction) const;
+
+    // Where addr is in the profiler's view, see Profiler
+    std::uint32_t         profileLocation(Address addr)
+    {
+        return addr < 0x8000 ? addr : 0x8000 + m_bus.getPRGOffset(addr);
+    }
+    // Called after the instruction at pc ran, before its cycles are added
+    void                  profile(std::uint32_t location, Address pc, Byte opcode);
+
+    // Called after a backward jump from pc
+    void                  trackLoop(Address pc);
+    bool                  isSideEffectFreeLoop(Address target, Address pc);
+
+    // Looks up the instruction at r_PC, decoding it if it isn't cached
+    const DecodedInstruction& fetchInstruction();
+    // Returns the opcode
+    Byte                  decode(Address addr, DecodedInstruction& instruction);
+    // Decodes the straight-line code in PRG-ROM from addr up to the next jump, branch or end of the 8KB window
+    void                  decodeBasicBlock(Address addr);
+
     // Instructions are split into five sets to make decoding easier.
-    // These functions return true if they succeed
-    bool                  executeImplied(Byte opcode);
-    bool                  executeBranch(Byte opcode);
-    bool                  executeType0(Byte opcode);
-    bool                  executeType1(Byte opcode);
-    bool                  executeType2(Byte opcode);
+    // Every opcode is decoded at compile time into one of these, see m_opcodeHandlers
+    template<OperationImplied Op>
+    void                  executeImplied();
+    template<BranchOnFlag Flag, bool Condition>
+    void                  executeBranch();
+    template<AddrMode2 Mode, Operation0 Op>
+    void                  executeType0();
+    template<AddrMode1 Mode, Operation1 Op>
+    void                  executeType1();
+    template<AddrMode2 Mode, Operation2 Op>
+    void                  executeType2();
+
+    template<Byte Opcode>
+    void                  executeOpcode();
 
     Address               readAddress(Address addr);
+    // Operands of the current instruction, as consumed by its handler
+    Byte                  fetchByte()
+    {
+        ++r_PC;
+        return m_operand;
+    }
+    Address               fetchAddress()
+    {
+        r_PC += 2;
+        return m_operand;
+    }
 
     void                  pushStack(Byte value);
     Byte                  pullStack();
 
     // If a and b are in different pages, increases the m_SkipCycles by 1
     void                  skipPageCrossCycle(Address a, Address b);
-    void                  setZN(Byte value);
+    void                  setZN(Byte value) { m_lastResult = value; }
 
     int                   m_skipCycles;
-    int                   m_cycles;
+    std::uint64_t         m_cycles;
 
     // Registers
     Address               r_PC;
@@ -75,21 +171,47 @@ private:
     Byte                  r_X;
     Byte                  r_Y;
 
-    // Status flags.
-    // Is storing them in one byte better ?
-    bool                  f_C;
-    bool                  f_Z;
-    bool                  f_I;
-    bool                  f_D;
-    bool                  f_V;
-    bool                  f_N;
+    // Status flags. Only V, D and I are stored in r_P, N, Z and C are derived from the last results when the
+    // status is observed, so most instructions only store a byte
+    Byte                  r_P;
+    // Z is set if the low byte is zero, N if bit 7 or 8 is set
+    std::uint16_t         m_lastResult;
+    // C is bit 8
+    std::uint16_t         m_carry;
+
+    bool                  getN() const { return m_lastResult & 0x180; }
+    bool                  getZ() const { return !(m_lastResult & 0xff); }
+    bool                  getC() const { return m_carry & 0x100; }
+    // Packs the flags for pushing, the B flag is left to the caller
+    Byte                  getStatus() const;
+    void                  setStatus(Byte flags);
 
     bool                  m_pendingNMI;
 
-    bool                  isPendingIRQ() const { return !f_I && m_irqPulldowns != 0; };
+    bool                  isPendingIRQ() const { return !(r_P & StatusI) && m_irqPulldowns != 0; };
 
     MainBus&              m_bus;
 
+    static const OpcodeHandler m_opcodeHandlers[0x100];
+
+    Address               m_operand;
+    // Instructions in PRG-ROM indexed by their ROM offset, so bank switches need no invalidation
+    std::vector<DecodedInstruction> m_decodedPRG;
+    // Code running from RAM or straddling two PRG windows is decoded anew each time
+    DecodedInstruction    m_uncachedInstruction;
+
+    bool                  m_skipIdleLoops;
+    bool                  m_hasLastLoop;
+    LoopState             m_lastLoop;
+    std::uint64_t         m_lastLoopCycle;
+    std::uint32_t         m_lastLoopStatusReads;
+    // Length of an iteration of the idle loop just detected, 0 if none
+    std::uint64_t         m_idleLoopCycles;
+    bool                  m_idleLoopPollsStatus;
+
+    CPUTraceRecorder*     m_traceRecorder;
+    Profiler*             m_profiler;
+
     // Each bit is assigned to an IRQ handler.
     // If any bits are set, it means the irq must be triggered
     int                   m_irqPulldowns = 0;
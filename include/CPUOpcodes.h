@@ -20,6 +20,14 @@ const auto NMIVector                   = 0xfffa;
 const auto ResetVector                 = 0xfffc;
 const auto IRQVector                   = 0xfffe;
 
+// Bits of the status register
+const auto StatusC                     = 0x01;
+const auto StatusZ                     = 0x02;
+const auto StatusI                     = 0x04;
+const auto StatusD                     = 0x08;
+const auto StatusV                     = 0x40;
+const auto StatusN                     = 0x80;
+
 enum BranchOnFlag
 {
     Negative,
@@ -128,7 +136,7 @@ enum InterruptType
 };
 
 // 0 implies unused opcode
-static const int OperationCycles[0x100] = {
+static constexpr int OperationCycles[0x100] = {
     // clang-format off
     7, 6, 0, 0, 0, 3, 5, 0, 3, 2, 2, 0, 0, 4, 6, 0,
     2, 5, 0, 0, 0, 4, 6, 0, 2, 4, 0, 0, 0, 4, 7, 0,
@@ -144,10 +152,100 @@ static const int OperationCycles[0x100] = {
     2, 5, 0, 0, 4, 4, 4, 0, 2, 4, 2, 0, 4, 4, 4, 0,
     2, 6, 0, 0, 3, 3, 5, 0, 2, 2, 2, 0, 4, 4, 6, 0,
     2, 5, 0, 0, 0, 4, 6, 0, 2, 4, 0, 0, 0, 4, 7, 0,
-    2, 6, 0, 0, 3, 3, 5, 0, 2, 2, 2, 2, 4, 4, 6, 0,
+    2, 6, 0, 0, 3, 3, 5, 0, 2, 2, 2, 0, 4, 4, 6, 0,
     2, 5, 0, 0, 0, 4, 6, 0, 2, 4, 0, 0, 0, 4, 7, 0,
     // clang-format on
 };
+
+// The groups in which an opcode is decoded, see decodeInstruction()
+enum InstructionType
+{
+    UnknownInstruction,
+    ImpliedInstruction,
+    BranchInstruction,
+    Type0Instruction,
+    Type1Instruction,
+    Type2Instruction,
+};
+
+constexpr bool isImpliedOpcode(int opcode)
+{
+    return opcode == NOP || opcode == BRK || opcode == JSR || opcode == RTI || opcode == RTS || opcode == JMP ||
+           opcode == JMPI || opcode == PHP || opcode == PLP || opcode == PHA || opcode == PLA || opcode == DEY ||
+           opcode == DEX || opcode == TAY || opcode == INY || opcode == INX || opcode == CLC || opcode == SEC ||
+           opcode == CLI || opcode == SEI || opcode == TYA || opcode == CLV || opcode == CLD || opcode == SED ||
+           opcode == TXA || opcode == TXS || opcode == TAX || opcode == TSX;
+}
+
+constexpr int decodeAddrMode(int opcode)
+{
+    return (opcode & AddrModeMask) >> AddrModeShift;
+}
+
+constexpr int decodeOperation(int opcode)
+{
+    return (opcode & OperationMask) >> OperationShift;
+}
+
+// Implied instructions must be matched first and branches must be matched before type 0, since their bit patterns
+// overlap with the generic ones
+constexpr InstructionType decodeInstruction(int opcode)
+{
+    return !OperationCycles[opcode] ? UnknownInstruction
+         : isImpliedOpcode(opcode)  ? ImpliedInstruction
+         : (opcode & BranchInstructionMask) == BranchInstructionMaskResult ? BranchInstruction
+         : (opcode & InstructionModeMask) == 0x1 ? Type1Instruction
+         : (opcode & InstructionModeMask) == 0x2 &&
+               (decodeAddrMode(opcode) != 4 && decodeAddrMode(opcode) != 6) ? Type2Instruction
+         : (opcode & InstructionModeMask) == 0x0 && (decodeAddrMode(opcode) != 2 && decodeAddrMode(opcode) != 4 &&
+                                                     decodeAddrMode(opcode) != 6) &&
+               (decodeOperation(opcode) == BIT || decodeOperation(opcode) >= STY) ? Type0Instruction
+                                                                                  : UnknownInstruction;
+}
+
+constexpr bool allOpcodesDecoded(int opcode = 0)
+{
+    return opcode == 0x100 || ((!OperationCycles[opcode] || decodeInstruction(opcode) != UnknownInstruction) &&
+                               allOpcodesDecoded(opcode + 1));
+}
+static_assert(allOpcodesDecoded(), "Every opcode with a cycle length must be decodable");
+
+// Number of bytes following the opcode that its handler consumes. BRK skips its padding byte by itself
+constexpr int operandLength(int opcode)
+{
+    return opcode == JSR || opcode == JMP || opcode == JMPI ? 2
+         : decodeInstruction(opcode) == BranchInstruction   ? 1
+         : decodeInstruction(opcode) == Type1Instruction
+             ? (decodeAddrMode(opcode) == Absolute || decodeAddrMode(opcode) == AbsoluteY ||
+                        decodeAddrMode(opcode) == AbsoluteX
+                    ? 2
+                    : 1)
+         : decodeInstruction(opcode) == Type0Instruction || decodeInstruction(opcode) == Type2Instruction
+             ? (decodeAddrMode(opcode) == Accumulator ? 0
+                : decodeAddrMode(opcode) == Absolute_ || decodeAddrMode(opcode) == AbsoluteIndexed ? 2
+                                                                                                     : 1)
+             : 0;
+}
+
+// Whether execution may continue anywhere else than the next instruction
+constexpr bool endsBasicBlock(int opcode)
+{
+    return decodeInstruction(opcode) == UnknownInstruction || decodeInstruction(opcode) == BranchInstruction ||
+           opcode == BRK || opcode == JSR || opcode == RTI || opcode == RTS || opcode == JMP || opcode == JMPI;
+}
+
+// Whether the instruction only reads memory and changes registers, so a loop of them can only wait
+constexpr bool isSideEffectFree(int opcode)
+{
+    return decodeInstruction(opcode) == BranchInstruction ||
+           (decodeInstruction(opcode) == Type1Instruction && decodeOperation(opcode) != STA) ||
+           (decodeInstruction(opcode) == Type0Instruction && decodeOperation(opcode) != STY) ||
+           (decodeInstruction(opcode) == Type2Instruction &&
+            (decodeOperation(opcode) == LDX || decodeAddrMode(opcode) == Accumulator)) ||
+           opcode == NOP || opcode == JMP || opcode == DEY || opcode == DEX || opcode == TAY || opcode == INY ||
+           opcode == INX || opcode == CLC || opcode == SEC || opcode == TYA || opcode == CLV || opcode == TXA ||
+           opcode == TAX || opcode == TSX;
+}
 };
 
 #endif // CPUOPCODES_H_INCLUDED
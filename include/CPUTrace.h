@@ -0,0 +1,79 @@
+#ifndef CPUTRACE_H
+#define CPUTRACE_H
+#include "Cartridge.h"
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace sn
+{
+const char CPUTraceMagic[8] = { 'S', 'N', 'T', 'R', 'A', 'C', 'E', '1' };
+
+// Start of a trace file, followed by capacity records
+struct CPUTraceHeader
+{
+    char          magic[8];
+    std::uint32_t recordSize;
+    std::uint32_t capacity;
+    // Records ever written, the oldest one is at written % capacity once the ring wrapped around
+    std::uint64_t written;
+};
+
+// State before an instruction runs
+struct CPUTraceRecord
+{
+    std::uint64_t cycle;
+    Address       pc;
+    // The operand bytes following the opcode, little endian
+    Address       operand;
+    // PPU dot of the cycle, as shown by the text log
+    std::uint16_t dot;
+    Byte          opcode;
+    Byte          a;
+    Byte          x;
+    Byte          y;
+    Byte          p;
+    Byte          sp;
+    Byte          reserved[2];
+};
+static_assert(sizeof(CPUTraceRecord) == 24, "Trace records are written as is");
+static_assert(sizeof(CPUTraceHeader) % alignof(CPUTraceRecord) == 0, "Records follow the header");
+
+// Writes records to a memory-mapped ring file, so tracing costs about as much as the stores
+class CPUTraceRecorder
+{
+public:
+    CPUTraceRecorder();
+    ~CPUTraceRecorder();
+
+    // Creates or truncates the file for the given number of records
+    bool            open(const std::string& path, std::uint32_t capacity);
+    void            close();
+    bool            isOpen() const { return m_header != nullptr; }
+
+    // The record to fill for the next instruction
+    CPUTraceRecord& next()
+    {
+        auto& record = m_records[m_index];
+        if (++m_index == m_header->capacity)
+            m_index = 0;
+        ++m_header->written;
+        return record;
+    }
+
+private:
+    CPUTraceHeader* m_header;
+    CPUTraceRecord* m_records;
+    std::uint32_t   m_index;
+    std::size_t     m_size;
+#ifdef _WIN32
+    void*           m_file;
+    void*           m_mapping;
+#endif
+};
+
+// Prints a record the same way as the CPU's text log
+std::ostream& operator<<(std::ostream& out, const CPUTraceRecord& record);
+};
+
+#endif // CPUTRACE_H
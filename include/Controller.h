@@ -1,5 +1,6 @@
 #ifndef CONTROLLER_H
 #define CONTROLLER_H
+#include "Snapshot.h"
 #include <SFML/Window.hpp>
 #include <cstdint>
 #include <vector>
@@ -27,6 +28,8 @@ public:
     void strobe(Byte b);
     Byte read();
     void setKeyBindings(const std::vector<sf::Keyboard::Key>& keys);
+    // Saves or restores the buttons being shifted out, see Snapshot
+    void snapshot(Snapshot& state);
 
 private:
     bool                           m_strobe;
@@ -1,7 +1,9 @@
 #ifndef EMULATOR_H
 #define EMULATOR_H
 #include <SFML/Graphics.hpp>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 
 #include "APU/APU.h"
 #include "AudioPlayer.h"
@@ -9,7 +11,9 @@
 #include "Controller.h"
 #include "MainBus.h"
 #include "PPU.h"
+#include "PPURenderer.h"
 #include "PictureBus.h"
+#include "Snapshot.h"
 
 namespace sn
 {
@@ -18,6 +22,8 @@ using Duration           = std::chrono::high_resolution_clock::duration;
 
 const int NESVideoWidth  = ScanlineVisibleDots;
 const int NESVideoHeight = VisibleScanlines;
+// Around one frame
+const int CPUFrameCycles = 29781;
 
 class Emulator
 {
@@ -29,12 +35,70 @@ public:
     void setVideoScale(float scale);
     void setKeys(std::vector<sf::Keyboard::Key>& p1, std::vector<sf::Keyboard::Key>& p2);
     void muteAudio();
+    // Records every instruction in binary to a ring file, see CPUTraceRecorder
+    void traceCPU(const std::string& path, std::uint32_t records);
+    // Fast-forwards the loops that wait for an interrupt or the PPU
+    void skipIdleLoops();
+    // Counts cycles per instruction and routine, the report is written to path on exit and with F6
+    void profile(const std::string& path);
+    // Only draws one in every frames + 1 frames, the others are run without putting pixels together
+    void setFrameSkip(int frames);
+    // Skips drawing the frames that the host can't keep up with
+    void autoFrameSkip();
+    // Draws the frames on a thread of their own, a frame late, see PPURenderer
+    void renderOnThread();
+    // Paces the emulation by the audio device's clock rather than the system's, see AudioPlayer::enableRateControl
+    void syncToAudio();
+    // Runs one frame at a time and sleeps until the next one is due, instead of running whatever time has passed
+    void runByFrames();
+    // Speed multiple while fast-forwarding, which is while Tab is held. 0 runs as fast as possible
+    void setFastForwardSpeed(int speed);
+    // Fast-forwards all the time
+    void fastForward();
+    // Shows each frame as it would be that many frames later with the input held, which takes back that many frames
+    // of the game's reaction time. The frames ahead are run again for every frame, see runAhead
+    void setRunAhead(int frames);
 
 private:
     void                    OAMDMA(Byte page);
     Byte                    DMCDMA(Address addr);
 
+    // Runs whole instructions for about the given number of CPU cycles, the PPU is only stepped when something
+    // could observe it, and brought up to date at the end
+    void                    runCycles(int cycles);
+    // The emulation thread, runs in real time until m_running is cleared
+    void                    emulate();
+    // Runs the next frame at the given speed multiple and waits for its deadline, see runByFrames
+    void                    runFrame(int speed);
+    void                    catchUpPPU(std::uint64_t cycle);
+    void                    skipIdleLoop();
+    void                    writeProfile();
+    void                    startRenderThread();
+    // Sets the frame skip of the PPU that draws
+    void                    skipFrames(int frames);
+    // Runs the next frame without showing it, then the frames ahead without playing them, and goes back to where
+    // the frame ended
+    void                    runAhead();
+    void                    runToFrameEnd();
+    // Saves or restores the state of the whole system, see Snapshot
+    void                    snapshot(Snapshot& state);
+
     CPU                     m_cpu;
+    CPUTraceRecorder        m_cpuTrace;
+    Profiler                m_profiler;
+    // Empty if not profiling
+    std::string             m_profilePath;
+
+    int                     m_frameSkip;
+    bool                    m_autoFrameSkip;
+    bool                    m_renderThread;
+    bool                    m_audioSync;
+    bool                    m_frameLoop;
+    int                     m_fastForwardSpeed;
+    bool                    m_fastForwardAlways;
+    int                     m_runAheadFrames;
+    // Where the last frame really ended, kept around to reuse its memory
+    Snapshot                m_runAheadState;
 
     AudioPlayer             m_audioPlayer;
 
@@ -50,11 +114,32 @@ private:
 
     sf::RenderWindow        m_window;
     VirtualScreen           m_emulatorScreen;
+    PPURenderer             m_renderer;
     float                   m_screenScale;
 
+    // Set by the window's thread for the emulation thread
+    std::atomic<bool>       m_running;
+    std::atomic<bool>       m_focus;
+    std::atomic<bool>       m_paused;
+    // Frames to run one by one while paused
+    std::atomic<int>        m_frameSteps;
+    std::atomic<bool>       m_profileRequested;
+    std::atomic<bool>       m_fastForwardHeld;
+
     TimePoint               m_lastWakeup;
 
     Duration                m_elapsedTime;
+
+    // Frames run by the frame loop, and how many of them ended after their deadline
+    std::uint64_t           m_frames;
+    std::uint64_t           m_missedDeadlines;
+
+    // CPU cycles the emulation should reach, the last instruction usually overshoots it
+    std::uint64_t           m_targetCycle;
+    // CPU cycles the PPU has been stepped through
+    std::uint64_t           m_ppuCycles;
+    // The CPU cycle before whose instruction the PPU has to catch up, as it may raise an interrupt
+    std::uint64_t           m_ppuInterruptCycle;
 };
 }
 #endif // EMULATOR_H
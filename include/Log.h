@@ -1,5 +1,6 @@
 #ifndef LOG_H
 #define LOG_H
+#include <atomic>
 #include <chrono>
 #include <cstring>
 #include <fstream>
@@ -59,9 +60,10 @@ public:
     static Log&   get();
 
 private:
-    Level         m_logLevel;
-    std::ostream* m_logStream;
-    std::ostream* m_cpuTrace;
+    // Set from the window thread while the emulation and render threads log
+    std::atomic<Level> m_logLevel;
+    std::ostream*      m_logStream;
+    std::ostream*      m_cpuTrace;
 };
 
 // Courtesy of http://wordaligned.org/articles/cpp-streambufs#toctee-streams
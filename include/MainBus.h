@@ -5,6 +5,9 @@
 #include "Controller.h"
 #include "Mapper.h"
 #include "PPU.h"
+#include "Snapshot.h"
+#include <array>
+#include <cstdint>
 #include <functional>
 #include <vector>
 
@@ -42,17 +45,64 @@ public:
     void        write(Address addr, Byte value);
     bool        setMapper(Mapper* mapper);
     const Byte* getPagePtr(Byte page);
+    // See Mapper::getPRGOffset
+    std::size_t getPRGOffset(Address addr) { return m_mapper->getPRGOffset(addr); }
+    std::size_t getPRGSize() { return m_mapper->getPRGSize(); }
+
+    // Count the register reads, which tells whether a loop polls the PPU status or anything else
+    std::uint32_t getStatusReads() const { return m_statusReads; }
+    std::uint32_t getRegisterReads() const { return m_registerReads; }
+
+    // Called before the registers or the mapper are accessed, so the rest of the system can catch up with the CPU
+    void        setSyncCallback(std::function<void(void)> cb);
+    // Called on every access that can change what the PPU draws: writes to its registers and the mapper with the
+    // value written, and reads of PPUSTATUS and PPUDATA with -1
+    void        setJournalCallback(std::function<void(Address, int)> cb);
+
+    // Saves or restores the RAM, and the page tables along with the mapper's banks
+    void        snapshot(Snapshot& state);
 
 private:
-    std::vector<Byte>         m_RAM;
-    std::vector<Byte>         m_extRAM;
-    std::function<void(Byte)> m_dmaCallback;
-    Mapper*                   m_mapper;
-    PPU&                      m_ppu;
-    APU&                      m_apu;
-    Controller&               m_controller1;
-    Controller&               m_controller2;
+    // Accesses of pages that aren't in the page tables: registers, the mapper, and the unmapped areas
+    Byte                      readIO(Address addr);
+    void                      writeIO(Address addr, Byte value);
+    void                      updatePRGPages();
+
+    // Pointers to every 256-byte page that can be accessed directly, nullptr otherwise
+    std::array<const Byte*, 0x100> m_readPages;
+    std::array<Byte*, 0x100>       m_writePages;
+
+    std::vector<Byte>                 m_RAM;
+    std::vector<Byte>                 m_extRAM;
+    std::function<void(Byte)>         m_dmaCallback;
+    std::function<void(void)>         m_syncCallback;
+    std::function<void(Address, int)> m_journalCallback;
+    Mapper*                           m_mapper;
+    std::uint32_t                     m_statusReads;
+    // Reads of the other registers, which may change their state
+    std::uint32_t                     m_registerReads;
+    PPU&                              m_ppu;
+    APU&                              m_apu;
+    Controller&                       m_controller1;
+    Controller&                       m_controller2;
 };
+
+inline Byte MainBus::read(Address addr)
+{
+    const Byte* page = m_readPages[addr >> 8];
+    if (page)
+        return page[addr & 0xff];
+    return readIO(addr);
+}
+
+inline void MainBus::write(Address addr, Byte value)
+{
+    Byte* page = m_writePages[addr >> 8];
+    if (page)
+        page[addr & 0xff] = value;
+    else
+        writeIO(addr, value);
+}
 };
 
 #endif // MEMORY_H
@@ -2,6 +2,8 @@
 #define MAPPER_H
 #include "Cartridge.h"
 #include "IRQ.h"
+#include "Snapshot.h"
+#include <array>
 #include <functional>
 #include <memory>
 
@@ -33,13 +35,44 @@ public:
 
     Mapper(Cartridge& cart, Type t)
       : m_cartridge(cart)
-      , m_type(t) {};
+      , m_type(t)
+      , m_prgWindows {}
+      , m_prgOffsets {}
+      , m_chrWindows {}
+      , m_chrOffsets {}
+      , m_chrWriteWindows {}
+      , m_chrVersion(0) {};
     virtual ~Mapper()                                             = default;
+    // Only the bank switching is left to the mappers, reads go straight through the windows
     virtual void               writePRG(Address addr, Byte value) = 0;
-    virtual Byte               readPRG(Address addr)              = 0;
+    Byte                       readPRG(Address addr) { return *getPRGPagePtr(addr); }
+    // Where the PRG byte at addr (>= 0x8000) lives, only valid until the next writePRG
+    const Byte*                getPRGPagePtr(Address addr) { return m_prgWindows[(addr >> 13) & 3] + (addr & 0x1fff); }
+    // Offset in PRG-ROM of the byte at addr (>= 0x8000), identifies it across bank switches
+    std::size_t                getPRGOffset(Address addr) { return m_prgOffsets[(addr >> 13) & 3] + (addr & 0x1fff); }
+    std::size_t                getPRGSize() { return m_cartridge.getROM().size(); }
 
-    virtual Byte               readCHR(Address addr)              = 0;
-    virtual void               writeCHR(Address addr, Byte value) = 0;
+    Byte                       readCHR(Address addr) { return m_chrWindows[addr >> 10][addr & 0x3ff]; }
+    void                       writeCHR(Address addr, Byte value);
+    // The pattern row whose low plane is at addr, as the 2-bit color of each pixel from the left, 2 bits apiece.
+    // Rows are decoded once and cached by their offset in CHR memory, so bank switches need no invalidation.
+    // addr wraps around the pattern tables and a row past the 8 of its tile wraps within it, so that an address worked
+    // out from a stale sprite can't reach out of the windows
+    std::uint16_t              getPatternRow(Address addr)
+    {
+        addr              &= 0x1ff7;
+        const auto offset  = m_chrOffsets[addr >> 10] + (addr & 0x3ff);
+        auto&      row     = m_patternRows[(offset >> 4 << 3) | (offset & 7)];
+        if (!row)
+            row = decodePatternRow(addr);
+        return row;
+    }
+    // Changes on every CHR bank switch and CHR-RAM write, so that what was drawn from the pattern tables can be
+    // told apart from what would be drawn now
+    std::uint32_t              getCHRVersion() const { return m_chrVersion; }
+
+    // 4KB of name tables on the cartridge for four screen mirroring, nullptr if there are none
+    virtual Byte*              getNameTableRAM() { return nullptr; }
 
     virtual NameTableMirroring getNameTableMirroring();
 
@@ -47,14 +80,37 @@ public:
 
     virtual void                   scanlineIRQ() {}
 
+    // Saves or restores the banks and CHR-RAM, the mappers add their registers
+    virtual void                   snapshot(Snapshot& state);
+
     static std::unique_ptr<Mapper> createMapper(Type                      mapper_t,
                                                 Cartridge&                cart,
                                                 IRQHandle&                irq,
                                                 std::function<void(void)> mirroring_cb);
 
 protected:
-    Cartridge& m_cartridge;
-    Type       m_type;
+    // Maps size bytes of PRG-ROM from offset to addr onwards, in 8KB windows. Offsets wrap around the ROM size
+    void                        mapPRG(Address addr, std::size_t size, std::size_t offset);
+    // Same for the pattern tables in 1KB windows, mapping CHR-RAM instead of CHR-ROM if the mapper allocated it
+    void                        mapCHR(Address addr, std::size_t size, std::size_t offset);
+
+    Cartridge&                  m_cartridge;
+    Type                        m_type;
+
+    std::vector<Byte>           m_characterRAM;
+
+private:
+    std::uint32_t               decodePatternRow(Address addr);
+
+    std::array<const Byte*, 4>  m_prgWindows;
+    std::array<std::size_t, 4>  m_prgOffsets;
+    std::array<const Byte*, 8>  m_chrWindows;
+    std::array<std::size_t, 8>  m_chrOffsets;
+    // nullptr for CHR-ROM
+    std::array<Byte*, 8>        m_chrWriteWindows;
+    // Decoded pattern rows of the CHR memory in use, 0 if not decoded yet, see getPatternRow
+    std::vector<std::uint32_t>  m_patternRows;
+    std::uint32_t               m_chrVersion;
 };
 }
 
@@ -5,21 +5,16 @@
 
 namespace sn
 {
-class MapperColorDreams : public Mapper
+class MapperColorDreams final : public Mapper
 {
 public:
     MapperColorDreams(Cartridge& cart, std::function<void(void)> mirroring_cb);
     NameTableMirroring getNameTableMirroring();
     void               writePRG(Address address, Byte value);
-    Byte               readPRG(Address address);
-
-    Byte               readCHR(Address address);
-    void               writeCHR(Address address, Byte value);
+    void               snapshot(Snapshot& state);
 
 private:
     NameTableMirroring        m_mirroring;
-    uint32_t                  prgbank;
-    uint32_t                  chrbank;
     std::function<void(void)> m_mirroringCallback;
 };
 }
@@ -6,21 +6,23 @@
 namespace sn
 {
 
-class MapperMMC3 : public Mapper
+class MapperMMC3 final : public Mapper
 {
 public:
     MapperMMC3(Cartridge& cart, IRQHandle& irq, std::function<void(void)> mirroring_cb);
 
-    Byte               readPRG(Address addr);
     void               writePRG(Address addr, Byte value);
 
     NameTableMirroring getNameTableMirroring();
-    Byte               readCHR(Address addr);
-    void               writeCHR(Address addr, Byte value);
+    Byte*              getNameTableRAM() { return m_mirroringRam.data(); }
 
     void               scanlineIRQ();
 
+    void               snapshot(Snapshot& state);
+
 private:
+    void                      mapCHRBanks();
+
     // Control variables
     uint32_t                  m_targetRegister;
     bool                      m_prgBankMode;
@@ -33,12 +35,7 @@ private:
     Byte                      m_irqLatch;
     bool                      m_irqReloadPending;
 
-    std::vector<Byte>         m_prgRam;
     std::vector<Byte>         m_mirroringRam;
-    const Byte*               m_prgBank0;
-    const Byte*               m_prgBank1;
-    const Byte*               m_prgBank2;
-    const Byte*               m_prgBank3;
 
     std::array<uint32_t, 8>   m_chrBanks;
 
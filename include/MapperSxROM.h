@@ -5,25 +5,22 @@
 namespace sn
 {
 
-class MapperSxROM : public Mapper
+class MapperSxROM final : public Mapper
 {
 public:
     MapperSxROM(Cartridge& cart, std::function<void(void)> mirroring_cb);
     void               writePRG(Address addr, Byte value);
-    Byte               readPRG(Address addr);
-
-    Byte               readCHR(Address addr);
-    void               writeCHR(Address addr, Byte value);
 
     NameTableMirroring getNameTableMirroring();
+    void               snapshot(Snapshot& state);
 
 private:
     void                      calculatePRGPointers();
+    void                      calculateCHRPointers();
 
     std::function<void(void)> m_mirroringCallback;
     NameTableMirroring        m_mirroing;
 
-    bool                      m_usesCharacterRAM;
     int                       m_modeCHR;
     int                       m_modePRG;
 
@@ -34,13 +31,8 @@ private:
     Byte                      m_regCHR0;
     Byte                      m_regCHR1;
 
-    const Byte*               m_firstBankPRG;
-    const Byte*               m_secondBankPRG;
-
     int                       m_firstBankCHRIdx;
     int                       m_secondBankCHRIdx;
-
-    std::vector<Byte>         m_characterRAM;
 };
 }
 #endif // MAPPERSXROM_H
@@ -1,8 +1,10 @@
 #ifndef PPU_H
 #define PPU_H
-#include "PaletteColors.h"
 #include "PictureBus.h"
+#include "Snapshot.h"
 #include "VirtualScreen.h"
+#include <array>
+#include <cstdint>
 #include <functional>
 
 namespace sn
@@ -20,12 +22,33 @@ class PPU
 public:
     PPU(PictureBus& bus, VirtualScreen& screen);
     void step();
+    // The same as that many calls to step(), but visible lines that fit are drawn whole and idle dots are skipped.
+    // The caller makes sure nothing observes or changes the PPU in between, see Emulator::catchUpPPU
+    void step(int steps);
     void reset();
 
+    // A lower bound on the steps until the PPU may next raise an NMI or clock the mapper's scanline IRQ
+    int  stepsUntilInterrupt() const;
+    // A lower bound on the steps until the value read from PPUSTATUS may change by itself
+    int  stepsUntilStatusChange() const;
+
+    // A lower bound on the steps until the current frame ends, after the last dot of the post-render line
+    int           stepsUntilFrameEnd() const { return stepsTo(VisibleScanlines, ScanlineEndCycle); }
+    // Frames ended since the reset
+    std::uint64_t getFrameCount() const { return m_frameCount; }
+
     void setInterruptCallback(std::function<void(void)> cb);
 
+    // From the next frame on, this many frames after each drawn one are only run: no pixels are put together and
+    // the screen keeps the last drawn frame, but sprite 0 hits, overflow and scanline IRQs happen as usual.
+    // A negative count skips every frame
+    void setFrameSkip(int frames);
+
     void doDMA(const Byte* page_ptr);
 
+    // Saves or restores everything but the pixels of the frame being drawn, which the next whole frame draws over
+    void snapshot(Snapshot& state);
+
     // Callbacks mapped to CPU address space
     // Addresses written to by the program
     void control(Byte ctrl);
@@ -41,6 +64,23 @@ public:
     void setOAMData(Byte value);
 
 private:
+    // Steps until the given dot of the given line is stepped, the pre-render line being -1
+    int                       stepsTo(int targetLine, int dot) const;
+    // Dots from the current one on that step() would only count
+    int                       idleDots() const;
+    // Draws the visible dots of the current line, as stepping through them would
+    void                      renderScanline();
+    // Whether sprite 0 could still hit on the current line, which needs its pixels even if the frame is skipped
+    bool                      canHitSpriteZero() const;
+    // Color of the background at x on the current line, moving on to the next tile after its last pixel
+    Byte                      backgroundPixel(int x);
+    // Loads the pattern row and the palette bits of the tile m_dataAddress points to
+    void                      fetchTile();
+    void                      incrementCoarseX();
+    // Draws the selected sprites of the current line into m_spriteLine
+    void                      prepareSpriteLine();
+    // Puts the background pixel together with the sprites on the current line
+    void                      drawPixel(int x, Byte bgColor);
     Byte                      readOAM(Byte addr);
     void                      writeOAM(Byte addr, Byte value);
     Byte                      read(Address addr);
@@ -53,6 +93,17 @@ private:
 
     std::vector<Byte>         m_scanlineSprites;
 
+    // The sprites' pixels on the current line: palette address, or 0 where no sprite is opaque, and these flags
+    enum SpritePixel
+    {
+        SpriteBehind = 0x20, // Same as the priority bit of the attribute
+        SpriteZero   = 0x40,
+    };
+    std::array<Byte, ScanlineVisibleDots> m_spriteLine;
+    bool                                  m_spriteLineReady;
+    // The pattern tables m_spriteLine was drawn from, see Mapper::getCHRVersion
+    std::uint32_t                         m_spriteLineCHR;
+
     enum State
     {
         PreRender,
@@ -64,9 +115,18 @@ private:
     int     m_scanline;
     bool    m_evenFrame;
 
+    std::uint64_t m_frameCount;
+
+    int     m_frameSkip;
+    int     m_skippedFrames;
+    // Whether the current frame is only run, not drawn
+    bool    m_skipFrame;
+
     bool    m_vblank;
     bool    m_sprZeroHit;
     bool    m_spriteOverflow;
+    // What the status reads as after the last read
+    Byte    m_lastStatus;
 
     // Registers
     Address m_dataAddress;
@@ -77,11 +137,18 @@ private:
 
     Byte    m_spriteDataAddress;
 
+    // Background pipeline: the 2-bit colors of the pixels left in the current tile, and its palette bits
+    std::uint16_t m_bgPatternShift;
+    Byte          m_bgAttributeLatch;
+    bool          m_bgTileFetched;
+
     // Setup flags and variables
     bool    m_longSprites;
     bool    m_generateInterrupt;
 
     bool    m_greyscaleMode;
+    // Color emphasis bits of PPUMASK, in place
+    Byte    m_emphasis;
     bool    m_showSprites;
     bool    m_showBackground;
     bool    m_hideEdgeSprites;
@@ -94,9 +161,12 @@ private:
     } m_bgPage,
       m_sprPage;
 
-    Address                             m_dataAddrIncrement;
+    Address           m_dataAddrIncrement;
 
-    std::vector<std::vector<sf::Color>> m_pictureBuffer;
+    // Palette indices of the frame being drawn, row by row
+    std::vector<Byte> m_frame;
+    // The greyscale and emphasis bits of PPUMASK for each line
+    std::vector<Byte> m_lineMasks;
 };
 }
 
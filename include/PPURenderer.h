@@ -0,0 +1,99 @@
+#ifndef PPURENDERER_H
+#define PPURENDERER_H
+#include "Cartridge.h"
+#include "IRQ.h"
+#include "Mapper.h"
+#include "PPU.h"
+#include "PictureBus.h"
+#include "VirtualScreen.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sn
+{
+// Draws the frames on a worker thread, so the emulated PPU only has to run its logic.
+// The worker has a PPU, picture bus and mapper of its own, and replays a journal of everything the emulated ones were
+// told at the dot they were told it. Starting out the same and getting the same input, it draws the same frames, one
+// batch later
+class PPURenderer
+{
+public:
+    PPURenderer(VirtualScreen& screen);
+    ~PPURenderer();
+
+    // Starts the worker with a mapper of its own for the cartridge, right after the emulated PPU's reset
+    bool start(Cartridge& cartridge, Mapper::Type type);
+    void stop();
+    bool isRunning() const { return m_thread.joinable(); }
+
+    // The journal, on the emulation thread. dot counts the steps of the emulated PPU since its reset.
+    // A write to a PPU register or the mapper, or for value -1 a read of PPUSTATUS or PPUDATA
+    void access(std::uint64_t dot, Address addr, int value);
+    void dma(std::uint64_t dot, const Byte* page);
+    // See PPU::setFrameSkip
+    void setFrameSkip(std::uint64_t dot, int frames);
+
+    // Hands the journal over to the worker, which draws up to dot. Blocks while the worker is two batches behind
+    void submit(std::uint64_t dot);
+
+private:
+    class NullIRQ : public IRQHandle
+    {
+    public:
+        void pull() override {}
+        void release() override {}
+    };
+
+    struct Entry
+    {
+        enum Type
+        {
+            Write,
+            Read,
+            DMA,       // value is the offset of the page in Batch::dmaPages
+            FrameSkip,
+        };
+
+        std::uint64_t dot;
+        Type          type;
+        Address       addr;
+        int           value;
+    };
+
+    struct Batch
+    {
+        std::vector<Entry> entries;
+        std::vector<Byte>  dmaPages;
+        std::uint64_t      end = 0;
+    };
+
+    void                    run();
+    void                    replay(const Batch& batch);
+    void                    write(Address addr, Byte value);
+    void                    stepTo(std::uint64_t dot);
+
+    PictureBus              m_bus;
+    PPU                     m_ppu;
+    NullIRQ                 m_irq;
+    std::unique_ptr<Mapper> m_mapper;
+    // Steps of the worker's PPU since its reset
+    std::uint64_t           m_dot;
+
+    // Being recorded, only touched by the emulation thread
+    Batch                   m_journal;
+
+    std::thread             m_thread;
+    std::mutex              m_mutex;
+    std::condition_variable m_condition;
+    // Submitted and not taken by the worker yet
+    std::deque<Batch>       m_batches;
+    bool                    m_stopping;
+};
+};
+
+#endif // PPURENDERER_H
@@ -2,6 +2,8 @@
 #define PICTUREBUS_H
 #include "Cartridge.h"
 #include "Mapper.h"
+#include "Snapshot.h"
+#include <array>
 #include <vector>
 
 namespace sn
@@ -10,21 +12,32 @@ class PictureBus
 {
 public:
     PictureBus();
-    Byte read(Address addr);
-    void write(Address addr, Byte value);
+    Byte          read(Address addr);
+    void          write(Address addr, Byte value);
+    // See Mapper::getPatternRow
+    std::uint16_t readPatternRow(Address addr) { return m_mapper->getPatternRow(addr); }
+    // See Mapper::getCHRVersion
+    std::uint32_t getCHRVersion() const { return m_mapper->getCHRVersion(); }
 
-    bool setMapper(Mapper* mapper);
-    Byte readPalette(Byte paletteAddr);
-    void updateMirroring();
-    void scanlineIRQ();
+    bool          setMapper(Mapper* mapper);
+    Byte          readPalette(Byte paletteAddr) { return m_palette[PaletteMirror[paletteAddr & 0x1f]]; }
+    void          updateMirroring();
+    void          scanlineIRQ();
+
+    // Saves or restores the name tables and palette, and where the mirroring put the name tables
+    void          snapshot(Snapshot& state);
 
 private:
-    std::size_t       NameTable0, NameTable1, NameTable2, NameTable3; // indices where they start in RAM vector
+    // Addresses $3F10/$3F14/$3F18/$3F1C are mirrors of $3F00/$3F04/$3F08/$3F0C, every entry maps to where it is stored
+    static const std::array<Byte, 0x20> PaletteMirror;
+
+    // Where the four 1KB name tables at 0x2000, 0x2400, 0x2800 and 0x2c00 are stored, set by the mirroring
+    std::array<Byte*, 4>                m_nameTables;
 
-    std::vector<Byte> m_palette;
+    std::vector<Byte>                   m_palette;
 
-    std::vector<Byte> m_RAM;
-    Mapper*           m_mapper;
+    std::vector<Byte>                   m_RAM;
+    Mapper*                             m_mapper;
 };
 }
 #endif // PICTUREBUS_H
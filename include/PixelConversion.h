@@ -0,0 +1,13 @@
+#ifndef PIXELCONVERSION_H
+#define PIXELCONVERSION_H
+#include <cstddef>
+#include <cstdint>
+
+namespace sn
+{
+// Converts count palette indices to RGBA pixels, bytes in that order in memory. The greyscale bit and the color
+// emphasis bits of PPUMASK in mask are applied along the way
+void convertPixels(const std::uint8_t* indices, std::uint8_t mask, std::uint32_t* rgba, std::size_t count);
+};
+
+#endif // PIXELCONVERSION_H
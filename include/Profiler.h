@@ -0,0 +1,72 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+#include "Cartridge.h"
+#include <cstdint>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+namespace sn
+{
+// Counts the executions and cycles of every instruction and routine the CPU runs.
+// Code is told apart by its location: its address below 0x8000, or 0x8000 + its PRG-ROM offset above, so the same
+// address in different banks is never mixed up
+class Profiler
+{
+public:
+    Profiler();
+
+    // Clears the counts, for a PRG-ROM of the given size
+    void reset(std::size_t prgSize);
+
+    void instruction(std::uint32_t location, Address pc, int cycles);
+    // A subroutine call or interrupt jumped to the routine at cycle. sp is the stack pointer before it pushed anything
+    void enter(std::uint32_t routine, Address pc, std::uint64_t cycle, Byte sp, bool nmi = false);
+    // A return left every routine entered with a stack pointer up to sp
+    void leave(std::uint64_t cycle, Byte sp);
+    // Cycles of a wait loop iteration, skipped ones are not counted as instructions
+    void waitLoop(std::uint64_t cycles, bool skipped);
+
+    // Sorted report of the hottest routines and instructions, the cost of the NMI handler and of the wait loops
+    void report(std::ostream& out, std::size_t lines = 20) const;
+
+private:
+    struct Counts
+    {
+        std::uint64_t executions;
+        std::uint64_t cycles;
+        Address       pc;
+    };
+
+    struct Routine
+    {
+        std::uint64_t calls;
+        std::uint64_t selfCycles;
+        std::uint64_t inclusiveCycles;
+        Address       pc;
+    };
+
+    struct Frame
+    {
+        Routine*      routine;
+        std::uint64_t start;
+        Byte          sp;
+        bool          nmi;
+    };
+
+    std::vector<Counts>                         m_instructions;
+    // Nodes of the map stay put, so frames can point into it
+    std::unordered_map<std::uint32_t, Routine> m_routines;
+    // Code outside any call, the reset handler
+    Routine                                     m_topLevel;
+    std::vector<Frame>                          m_frames;
+
+    std::uint64_t                               m_cycles;
+    std::uint64_t                               m_waitCycles;
+    std::uint64_t                               m_nmiCount;
+    std::uint64_t                               m_nmiCycles;
+    std::uint64_t                               m_nmiMaxCycles;
+};
+};
+
+#endif // PROFILER_H
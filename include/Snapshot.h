@@ -0,0 +1,75 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace sn
+{
+// The state of the emulated system at one point, to go back to later in the same run. Pointers are kept as they are.
+// Every part lists its state once, in a snapshot() method passing its members to the snapshot, which saves or
+// restores them depending on how it was begun. The memory is kept from one snapshot to the next
+class Snapshot
+{
+public:
+    void beginSave()
+    {
+        m_saving   = true;
+        m_position = 0;
+        m_data.clear();
+    }
+    // Restores from the beginning of what was saved, in the same order
+    void beginRestore()
+    {
+        m_saving   = false;
+        m_position = 0;
+    }
+
+    template<typename T, typename... Rest>
+    void operator()(T& value, Rest&... rest)
+    {
+        transfer(value);
+        (*this)(rest...);
+    }
+    void operator()() {}
+
+private:
+    template<typename T>
+    void transfer(T& value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be copied byte by byte");
+        copy(&value, sizeof(T));
+    }
+
+    template<typename T>
+    void transfer(std::vector<T>& values)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be copied byte by byte");
+        auto size = values.size();
+        transfer(size);
+        values.resize(size);
+        copy(values.data(), size * sizeof(T));
+    }
+
+    void copy(void* data, std::size_t size)
+    {
+        if (m_saving)
+        {
+            const auto bytes = static_cast<const unsigned char*>(data);
+            m_data.insert(m_data.end(), bytes, bytes + size);
+        }
+        else
+        {
+            std::memcpy(data, m_data.data() + m_position, size);
+            m_position += size;
+        }
+    }
+
+    bool                       m_saving   = true;
+    std::size_t                m_position = 0;
+    std::vector<unsigned char> m_data;
+};
+};
+
+#endif // SNAPSHOT_H
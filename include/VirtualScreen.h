@@ -1,21 +1,41 @@
 #ifndef VIRTUALSCREEN_H
 #define VIRTUALSCREEN_H
 #include <SFML/Graphics.hpp>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
 
 namespace sn
 {
+// A texture the size of the picture, scaled up when drawn
 class VirtualScreen : public sf::Drawable
 {
 public:
     void create(unsigned int width, unsigned int height, float pixel_size, sf::Color color);
-    void setPixel(std::size_t x, std::size_t y, sf::Color color);
+    // Shows a frame of row-major palette indices, lineMasks holds the PPUMASK bits each line was drawn with.
+    // It can be set from another thread than the one drawing
+    void setFrame(const std::uint8_t* indices, const std::uint8_t* lineMasks);
+    // Uploads the last frame set to the texture, on the thread drawing. Returns false if there was no new one
+    bool update();
 
 private:
-    void            draw(sf::RenderTarget& target, sf::RenderStates states) const;
+    void                                      draw(sf::RenderTarget& target, sf::RenderStates states) const;
 
-    sf::Vector2u    m_screenSize;
-    float           m_pixelSize; // virtual pixel size in real pixels
-    sf::VertexArray m_vertices;
+    // Set in the ready buffer's index until it is taken
+    static const int                          NewFrame = 4;
+
+    sf::Vector2u                              m_screenSize;
+    sf::Texture                               m_texture;
+    sf::Sprite                                m_sprite;
+    // Converted frames, uploaded to the texture as they are. The one being set, the last one finished and the one
+    // uploaded are swapped around, so neither thread ever waits for the other
+    std::array<std::vector<std::uint32_t>, 3> m_buffers;
+    // Only touched by the thread setting frames
+    int                                       m_writeBuffer;
+    // Only touched by the thread drawing
+    int                                       m_readBuffer;
+    std::atomic<int>                          m_readyBuffer;
 };
 };
 #endif // VIRTUALSCREEN_H
@@ -1,5 +1,7 @@
 #include "Emulator.h"
 #include "Log.h"
+#include <cstdint>
+#include <limits>
 #include <sstream>
 #include <string>
 
@@ -22,6 +24,7 @@ int main(int argc, char** argv)
 
     std::string                    path;
     std::string                    keybindingsPath = "keybindings.conf";
+    std::uint32_t                  traceRecords    = 0;
 
     // Default keybindings
     std::vector<sf::Keyboard::Key> p1 { sf::Keyboard::J, sf::Keyboard::K, sf::Keyboard::RShift, sf::Keyboard::Return,
@@ -41,7 +44,25 @@ int main(int argc, char** argv)
                       << "Usage: SimpleNES [options] rom-path\n\n"
                       << "Options:\n"
                       << "-h, --help             Print this help text and exit\n"
+                      << "--log-cpu              Log every instruction as text to sn.cpudump\n"
+                      << "--trace-cpu [records]  Record every instruction in binary to the ring file\n"
+                      << "                       sn.cputrace. Default size: 4194304 records.\n"
+                      << "                       Convert it to text with SimpleNES-tracedump\n"
                       << "--mute-audio           Mute audio\n"
+                      << "--audio-sync           Pace the emulation by the audio device's clock\n"
+                      << "--skip-idle            Fast-forward the loops waiting for vblank or an interrupt\n"
+                      << "--profile              Count cycles per instruction and routine, and write the\n"
+                      << "                       hottest ones to sn.profile on exit and with F6\n"
+                      << "--frame-loop           Run a frame at a time and sleep until the next one is\n"
+                      << "                       due, counting the missed deadlines\n"
+                      << "--fast-forward         Fast-forward all the time, not only while Tab is held\n"
+                      << "--fast-forward-speed N Speed multiple when fast-forwarding. Default: 0, as fast\n"
+                      << "                       as possible\n"
+                      << "--frameskip N|auto     Draw only one in every N + 1 frames, or skip the frames\n"
+                      << "                       that can't be drawn in time with auto\n"
+                      << "--render-thread        Draw the frames on a second thread, a frame late\n"
+                      << "--run-ahead N          Show the frame N frames ahead with the input held, to take\n"
+                      << "                       N frames off the input lag. Runs N + 1 frames per frame\n"
                       << "-s, --scale            Set video scale. Default: 3.\n"
                       << "                       Scale of 1 corresponds to " << sn::NESVideoWidth << "x"
                       << sn::NESVideoHeight << std::endl
@@ -62,11 +83,97 @@ int main(int argc, char** argv)
             sn::Log::get().setCpuTraceStream(cpuTraceFile);
             LOG(sn::Info) << "CPU logging set." << std::endl;
         }
+        else if (arg == "--trace-cpu")
+        {
+            // The size is optional, so only take the next argument if it is a number
+            std::int64_t      records;
+            std::stringstream ss;
+            traceRecords = 1 << 22;
+            if (i + 1 < argc && ss << argv[i + 1] && ss >> records && ss.eof())
+            {
+                ++i;
+                if (records > 0 && records <= std::numeric_limits<std::uint32_t>::max())
+                    traceRecords = static_cast<std::uint32_t>(records);
+                else
+                    LOG(sn::Error) << "Setting CPU trace size from argument failed" << std::endl;
+            }
+        }
         else if (arg == "--mute-audio")
         {
             emulator.muteAudio();
             LOG(sn::Info) << "Audio muted." << std::endl;
         }
+        else if (arg == "--audio-sync")
+        {
+            emulator.syncToAudio();
+            LOG(sn::Info) << "Syncing to the audio device." << std::endl;
+        }
+        else if (arg == "--skip-idle")
+        {
+            emulator.skipIdleLoops();
+            LOG(sn::Info) << "Skipping idle loops." << std::endl;
+        }
+        else if (arg == "--profile")
+        {
+            emulator.profile("sn.profile");
+            LOG(sn::Info) << "Profiling the CPU." << std::endl;
+        }
+        else if (arg == "--frame-loop")
+        {
+            emulator.runByFrames();
+            LOG(sn::Info) << "Running a frame at a time." << std::endl;
+        }
+        else if (arg == "--fast-forward")
+        {
+            emulator.fastForward();
+            LOG(sn::Info) << "Fast-forwarding." << std::endl;
+        }
+        else if (arg == "--fast-forward-speed")
+        {
+            int               speed;
+            std::stringstream ss;
+            if (i + 1 < argc && ss << argv[i + 1] && ss >> speed && speed >= 0)
+                emulator.setFastForwardSpeed(speed);
+            else
+                LOG(sn::Error) << "Setting fast-forward speed from argument failed" << std::endl;
+            ++i;
+        }
+        else if (arg == "--frameskip")
+        {
+            int               frames;
+            std::stringstream ss;
+            if (i + 1 < argc && std::strcmp(argv[i + 1], "auto") == 0)
+            {
+                emulator.autoFrameSkip();
+                LOG(sn::Info) << "Skipping frames when behind." << std::endl;
+            }
+            else if (i + 1 < argc && ss << argv[i + 1] && ss >> frames && frames >= 0)
+            {
+                emulator.setFrameSkip(frames);
+                LOG(sn::Info) << "Drawing one in every " << frames + 1 << " frames." << std::endl;
+            }
+            else
+                LOG(sn::Error) << "Setting frame skip from argument failed" << std::endl;
+            ++i;
+        }
+        else if (arg == "--render-thread")
+        {
+            emulator.renderOnThread();
+            LOG(sn::Info) << "Drawing on a render thread." << std::endl;
+        }
+        else if (arg == "--run-ahead")
+        {
+            int               frames;
+            std::stringstream ss;
+            if (i + 1 < argc && ss << argv[i + 1] && ss >> frames && frames >= 0)
+            {
+                emulator.setRunAhead(frames);
+                LOG(sn::Info) << "Running " << frames << " frames ahead." << std::endl;
+            }
+            else
+                LOG(sn::Error) << "Setting run-ahead from argument failed" << std::endl;
+            ++i;
+        }
         else if (arg == "-s" || arg == "--scale")
         {
             float             scale;
@@ -117,6 +224,9 @@ int main(int argc, char** argv)
         return 1;
     }
 
+    if (traceRecords)
+        emulator.traceCPU("sn.cputrace", traceRecords);
+
     sn::parseControllerConf(std::move(keybindingsPath), p1, p2);
     emulator.setKeys(p1, p2);
     emulator.run(path);
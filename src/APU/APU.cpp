@@ -82,11 +82,29 @@ void APU::step()
         pulse1.clock();
         pulse2.clock();
 
-        audio_queue.push(mix(pulse1.sample(), pulse2.sample(), triangle.sample(), noise.sample(), dmc.sample()));
+        decimated_sum += mix(pulse1.sample(), pulse2.sample(), triangle.sample(), noise.sample(), dmc.sample());
+        if (++decimated_count >= sample_decimation)
+        {
+            if (output_enabled)
+                audio_queue.push(decimated_sum / decimated_count);
+            decimated_sum   = 0;
+            decimated_count = 0;
+        }
     }
     divideByTwo = !divideByTwo;
 }
 
+void APU::snapshot(Snapshot& state)
+{
+    pulse1.snapshot(state);
+    pulse2.snapshot(state);
+    triangle.snapshot(state);
+    noise.snapshot(state);
+    dmc.snapshot(state);
+    frame_counter.snapshot(state);
+    state(divideByTwo, decimated_count, decimated_sum);
+}
+
 void APU::writeRegister(Address addr, Byte value)
 {
     switch (addr)
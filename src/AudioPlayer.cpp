@@ -1,9 +1,36 @@
 #include "AudioPlayer.h"
 #include "Log.h"
 #include "miniaudio.h"
+#include <algorithm>
+#include <cmath>
 
 namespace sn
 {
+namespace
+{
+    // Samples one callback takes from the queue
+    double callback_input_frames(int input_sample_rate)
+    {
+        return input_sample_rate * std::chrono::duration<double>(callback_period_ms).count();
+    }
+
+    // Consumes a little faster when more than the target is queued and slower when less is
+    void adjust_rate(CallbackData& cb_data)
+    {
+        const double period     = callback_input_frames(cb_data.input_sample_rate);
+        const double error      = (cb_data.ring_buffer.size() - target_buffer_rounds * period) / period;
+        const double adjustment =
+          std::max(-max_rate_adjustment, std::min(max_rate_adjustment, error * max_rate_adjustment));
+        const auto   rate       = static_cast<ma_uint32>(std::lround(cb_data.input_sample_rate * (1 + adjustment)));
+        if (rate != cb_data.resampled_rate)
+        {
+            // Unlike a fresh init, this keeps the resampler's cached frames, so there is no pop
+            ma_resampler_set_rate(cb_data.resampler, rate, cb_data.resampler->sampleRateOut);
+            cb_data.resampled_rate = rate;
+        }
+    }
+}
+
 void data_callback(ma_device*                   device,
                    void*                        output,
                    [[maybe_unused]] const void* input,
@@ -16,15 +43,15 @@ void data_callback(ma_device*                   device,
 
     CallbackData& cb_data = *(CallbackData*)device->pUserData;
 
-    if (cb_data.mute)
+    if (cb_data.remaining_buffer_rounds-- > 0)
     {
+        LOG(sn::Info) << "skipping buffer round" << std::endl;
         return;
     }
 
-    if (cb_data.remaining_buffer_rounds-- > 0)
+    if (cb_data.rate_control)
     {
-        LOG(sn::Info) << "skipping buffer round" << std::endl;
-        return;
+        adjust_rate(cb_data);
     }
 
     ma_uint64 presample_input_frames = 0;
@@ -40,6 +67,11 @@ void data_callback(ma_device*                   device,
     cb_data.input_frames_buffer.resize(presample_input_frames);
     ma_uint64 presample_frames_avail =
       cb_data.ring_buffer.pop(cb_data.input_frames_buffer.data(), presample_input_frames);
+    // The samples are still taken when muted, so the queue doesn't fill up
+    if (cb_data.mute)
+    {
+        return;
+    }
     // copy the last sample
     if (presample_frames_avail < presample_input_frames && presample_frames_avail > 0)
     {
@@ -120,4 +152,14 @@ void AudioPlayer::mute()
     cb_data.mute = true;
 }
 
+void AudioPlayer::enableRateControl()
+{
+    cb_data.rate_control = true;
+}
+
+bool AudioPlayer::isQueueFull()
+{
+    return audio_queue.size() > (target_buffer_rounds + 1) * callback_input_frames(input_sample_rate);
+}
+
 }
@@ -1,13 +1,16 @@
 #include "CPU.h"
 #include "CPUOpcodes.h"
 #include "Log.h"
-#include <iomanip>
+#include <algorithm>
 
 namespace sn
 {
 CPU::CPU(MainBus& mem)
   : m_pendingNMI(false)
   , m_bus(mem)
+  , m_skipIdleLoops(false)
+  , m_traceRecorder(nullptr)
+  , m_profiler(nullptr)
 {
 }
 
@@ -20,10 +23,16 @@ void CPU::reset(Address start_addr)
 {
     m_skipCycles = m_cycles = 0;
     r_A = r_X = r_Y = 0;
-    f_I             = true;
-    f_C = f_D = f_N = f_V = f_Z = false;
-    r_PC                        = start_addr;
-    r_SP                        = 0xfd; // documented startup state
+    setStatus(StatusI);
+    r_PC = start_addr;
+    r_SP = 0xfd; // documented startup state
+
+    m_hasLastLoop    = false;
+    m_idleLoopCycles = 0;
+
+    m_decodedPRG.assign(m_bus.getPRGSize(), DecodedInstruction());
+    if (m_profiler)
+        m_profiler->reset(m_bus.getPRGSize());
 }
 
 void CPU::nmiInterrupt()
@@ -56,7 +65,7 @@ void CPU::setIRQPulldown(int bit, bool state)
 
 void CPU::interruptSequence(InterruptType type)
 {
-    if (f_I && type != NMI && type != BRK_)
+    if ((r_P & StatusI) && type != NMI && type != BRK_)
         return;
 
     if (type == BRK_) // Add one if BRK, a quirk of 6502
@@ -65,12 +74,10 @@ void CPU::interruptSequence(InterruptType type)
     pushStack(r_PC >> 8);
     pushStack(r_PC);
 
-    Byte flags = f_N << 7 | f_V << 6 | 1 << 5 | // unused bit, supposed to be always 1
-                 (type == BRK_) << 4 |          // B flag set if BRK
-                 f_D << 3 | f_I << 2 | f_Z << 1 | f_C;
-    pushStack(flags);
+    pushStack(getStatus() | (type == BRK_) << 4); // B flag set if BRK
 
-    f_I = true;
+    r_P           |= StatusI;
+    m_hasLastLoop  = false;
 
     switch (type)
     {
@@ -83,6 +90,9 @@ void CPU::interruptSequence(InterruptType type)
         break;
     }
 
+    if (m_profiler)
+        m_profiler->enter(profileLocation(r_PC), r_PC, m_cycles, r_SP + 3, type == NMI);
+
     // Interrupt sequence takes 7
     m_skipCycles += 7;
 }
@@ -98,10 +108,17 @@ Byte CPU::pullStack()
     return m_bus.read(0x100 | ++r_SP);
 }
 
-void CPU::setZN(Byte value)
+Byte CPU::getStatus() const
 {
-    f_Z = !value;
-    f_N = value & 0x80;
+    return getN() << 7 | r_P | 1 << 5 | // unused bit, supposed to be always 1
+           getZ() << 1 | getC();
+}
+
+void CPU::setStatus(Byte flags)
+{
+    r_P          = flags & (StatusV | StatusD | StatusI);
+    m_lastResult = (flags & StatusZ ? 0 : 1) | (flags & StatusN) << 1;
+    m_carry      = (flags & StatusC) << 8;
 }
 
 void CPU::skipPageCrossCycle(Address a, Address b)
@@ -113,23 +130,19 @@ void CPU::skipPageCrossCycle(Address a, Address b)
 
 void CPU::skipOAMDMACycles()
 {
-    m_skipCycles += 513;            // 256 read + 256 write + 1 dummy read
-    m_skipCycles += (m_cycles & 1); //+1 if on odd cycle
+    m_skipCycles += 513;             // 256 read + 256 write + 1 dummy read
+    m_skipCycles += !(m_cycles & 1); //+1 if on odd cycle, counting from one
 }
 
 void CPU::skipDMCDMACycles()
 {
     // Cycles to skip depends on alignment and what not, but we keep it simple and just wait 3 on average
-    m_skipCycles += 3;
+    // This happens while the APU catches up with an instruction, so it delays the next one directly
+    m_cycles += 3;
 }
 
 void CPU::step()
 {
-    ++m_cycles;
-
-    if (m_skipCycles-- > 1)
-        return;
-
     m_skipCycles = 0;
 
     // NMI has higher priority, check for it first
@@ -137,46 +150,251 @@ void CPU::step()
     {
         interruptSequence(NMI);
         m_pendingNMI = false;
-        return;
     }
     else if (isPendingIRQ())
     {
         interruptSequence(IRQ);
-        return;
+    }
+    else
+    {
+        const auto& instruction = fetchInstruction();
+        if (m_traceRecorder)
+            m_traceRecorder->next() = makeTraceRecord(instruction);
+        LOG_CPU << makeTraceRecord(instruction) << std::endl;
+
+        const auto  start       = r_PC;
+        // Before the instruction runs, as it may switch its own bank
+        const auto  location    = m_profiler ? profileLocation(start) : 0;
+        m_operand               = instruction.operand;
+        ++r_PC;
+
+        // Unrecognized opcodes have a cycle length of 0, their handler only logs an error
+        (this->*instruction.handler)();
+        m_skipCycles += instruction.cycles;
+
+        if ((m_skipIdleLoops || m_profiler) && r_PC <= start)
+            trackLoop(start);
+        if (m_profiler)
+            profile(location, start, instruction.opcode);
+        // m_cycles %= 340; //compatibility with Nintendulator log
+    }
+
+    // Even an unrecognized opcode occupies the cycle it was fetched in
+    m_cycles += std::max(m_skipCycles, 1);
+}
+
+CPUTraceRecord CPU::makeTraceRecord(const DecodedInstruction& instruction) const
+{
+    CPUTraceRecord record {};
+    record.cycle   = m_cycles;
+    record.pc      = r_PC;
+    record.operand = instruction.operand;
+    record.dot     = (m_cycles * 3) % 341;
+    record.opcode  = instruction.opcode;
+    record.a       = r_A;
+    record.x       = r_X;
+    record.y       = r_Y;
+    record.p       = getStatus();
+    record.sp      = r_SP;
+    return record;
+}
+
+void CPU::setTraceRecorder(CPUTraceRecorder* recorder)
+{
+    m_traceRecorder = recorder;
+}
+
+void CPU::setProfiler(Profiler* profiler)
+{
+    m_profiler = profiler;
+}
+
+void CPU::profile(std::uint32_t location, Address pc, Byte opcode)
+{
+    const auto end = m_cycles + std::max(m_skipCycles, 1);
+    m_profiler->instruction(location, pc, end - m_cycles);
+    if (opcode == JSR)
+        m_profiler->enter(profileLocation(r_PC), r_PC, end, r_SP + 2);
+    else if (opcode == RTS || opcode == RTI)
+        m_profiler->leave(end, r_SP);
+}
+
+void CPU::snapshot(Snapshot& state)
+{
+    state(m_skipCycles, m_cycles, r_PC, r_SP, r_A, r_X, r_Y, r_P, m_lastResult, m_carry, m_pendingNMI, m_operand);
+    state(m_hasLastLoop,
+          m_lastLoop,
+          m_lastLoopCycle,
+          m_lastLoopStatusReads,
+          m_idleLoopCycles,
+          m_idleLoopPollsStatus,
+          m_irqPulldowns);
+}
+
+void CPU::setIdleLoopSkipping(bool enable)
+{
+    m_skipIdleLoops = enable;
+}
+
+bool CPU::skipIdleIteration(std::uint64_t limit)
+{
+    // Whole iterations leave the CPU exactly as it is, as long as nothing the loop reads changes until limit
+    if (m_idleLoopCycles && m_cycles + m_idleLoopCycles <= limit && !m_pendingNMI && !isPendingIRQ())
+    {
+        m_cycles        += m_idleLoopCycles;
+        m_lastLoopCycle += m_idleLoopCycles;
+        if (m_profiler)
+            m_profiler->waitLoop(m_idleLoopCycles, true);
+        return true;
+    }
+    m_idleLoopCycles = 0;
+    return false;
+}
+
+void CPU::trackLoop(Address pc)
+{
+    LoopState state = { pc, r_PC, r_A, r_X, r_Y, r_SP, getStatus(), m_bus.getRegisterReads() };
+
+    // Coming back in the same state means the iteration changed nothing, so the next ones won't either
+    if (m_hasLastLoop && state == m_lastLoop && isSideEffectFreeLoop(r_PC, pc))
+    {
+        // The profiler finds wait loops this way too, without skipping them
+        if (m_profiler)
+            m_profiler->waitLoop(m_cycles - m_lastLoopCycle, false);
+        if (m_skipIdleLoops)
+        {
+            m_idleLoopCycles      = m_cycles - m_lastLoopCycle;
+            m_idleLoopPollsStatus = m_bus.getStatusReads() != m_lastLoopStatusReads;
+        }
     }
 
-    int psw = f_N << 7 | f_V << 6 | 1 << 5 | f_D << 3 | f_I << 2 | f_Z << 1 | f_C;
-    LOG_CPU << std::hex << std::setfill('0') << std::uppercase << std::setw(4) << +r_PC << "  " << std::setw(2)
-            << +m_bus.read(r_PC) << "  "
-            << "A:" << std::setw(2) << +r_A << " "
-            << "X:" << std::setw(2) << +r_X << " "
-            << "Y:" << std::setw(2) << +r_Y << " "
-            << "P:" << std::setw(2) << psw << " "
-            << "SP:" << std::setw(2) << +r_SP << /*std::endl;*/ " " << "CYC:" << std::setw(3) << std::setfill(' ')
-            << std::dec << ((m_cycles - 1) * 3) % 341 << std::endl;
+    m_hasLastLoop         = true;
+    m_lastLoop            = state;
+    m_lastLoopCycle       = m_cycles;
+    m_lastLoopStatusReads = m_bus.getStatusReads();
+}
 
-    Byte opcode      = m_bus.read(r_PC++);
+bool CPU::isSideEffectFreeLoop(Address target, Address pc)
+{
+    // Only short loops in RAM or PRG-ROM, so decoding them has no side effects
+    if (pc - target > 0x20 || (target >= 0x2000 && target < 0x8000))
+        return false;
 
-    auto CycleLength = OperationCycles[opcode];
+    for (Address addr = target; addr <= pc;)
+    {
+        Byte opcode = m_bus.read(addr);
+        if (!isSideEffectFree(opcode))
+            return false;
+        if (addr == pc)
+            return true;
+
+        // Jumps before the end can only leave the loop, so the iterations run straight through it
+        if (opcode == JMP)
+            return false;
+        if (decodeInstruction(opcode) == BranchInstruction &&
+            static_cast<Address>(addr + 2 + static_cast<int8_t>(m_bus.read(addr + 1))) <= pc)
+            return false;
 
-    // Using short-circuit evaluation, call the other function only if the first failed
-    // ExecuteImplied must be called first and ExecuteBranch must be before ExecuteType0
-    if (CycleLength && (executeImplied(opcode) || executeBranch(opcode) || executeType1(opcode) ||
-                        executeType2(opcode) || executeType0(opcode)))
+        addr += 1 + operandLength(opcode);
+    }
+    return false;
+}
+
+const CPU::DecodedInstruction& CPU::fetchInstruction()
+{
+    // PRG-ROM never changes, so its instructions stay valid once decoded as long as they don't cross windows
+    if (r_PC >= 0x8000 && (r_PC & 0x1fff) <= 0x1ffd)
     {
-        m_skipCycles += CycleLength;
-        // m_cycles %= 340; //compatibility with Nintendulator log
-        // m_skipCycles = 0; //for TESTING
+        const auto& instruction = m_decodedPRG[m_bus.getPRGOffset(r_PC)];
+        if (!instruction.handler)
+            decodeBasicBlock(r_PC);
+        return instruction;
     }
-    else
+
+    decode(r_PC, m_uncachedInstruction);
+    return m_uncachedInstruction;
+}
+
+Byte CPU::decode(Address addr, DecodedInstruction& instruction)
+{
+    Byte opcode         = m_bus.read(addr);
+    instruction.handler = m_opcodeHandlers[opcode];
+    instruction.opcode  = opcode;
+    instruction.cycles  = OperationCycles[opcode];
+    instruction.length  = 1 + operandLength(opcode);
+    instruction.operand = 0;
+    if (instruction.length == 2)
+        instruction.operand = m_bus.read(addr + 1);
+    else if (instruction.length == 3)
+        instruction.operand = readAddress(addr + 1);
+    return opcode;
+}
+
+void CPU::decodeBasicBlock(Address addr)
+{
+    while (addr >= 0x8000 && (addr & 0x1fff) <= 0x1ffd)
     {
-        LOG(Error) << "Unrecognized opcode: " << std::hex << +opcode << std::endl;
+        auto& instruction = m_decodedPRG[m_bus.getPRGOffset(addr)];
+        if (instruction.handler)
+            break;
+
+        if (endsBasicBlock(decode(addr, instruction)))
+            break;
+        addr += instruction.length;
+    }
+}
+
+template<Byte Opcode>
+void CPU::executeOpcode()
+{
+    // The opcode is a constant here, so only the matching branch survives and
+    // the addressing mode is resolved at compile time
+    switch (decodeInstruction(Opcode))
+    {
+    case ImpliedInstruction:
+        executeImplied<static_cast<OperationImplied>(Opcode)>();
+        break;
+    case BranchInstruction:
+        executeBranch<static_cast<BranchOnFlag>(Opcode >> BranchOnFlagShift), bool(Opcode & BranchConditionMask)>();
+        break;
+    case Type1Instruction:
+        executeType1<static_cast<AddrMode1>(decodeAddrMode(Opcode)), static_cast<Operation1>(decodeOperation(Opcode))>();
+        break;
+    case Type2Instruction:
+        executeType2<static_cast<AddrMode2>(decodeAddrMode(Opcode)), static_cast<Operation2>(decodeOperation(Opcode))>();
+        break;
+    case Type0Instruction:
+        executeType0<static_cast<AddrMode2>(decodeAddrMode(Opcode)), static_cast<Operation0>(decodeOperation(Opcode))>();
+        break;
+    case UnknownInstruction:
+        LOG(Error) << "Unrecognized opcode: " << std::hex << +Opcode << std::endl;
+        break;
     }
 }
 
-bool CPU::executeImplied(Byte opcode)
+// clang-format off
+#define OPCODE_HANDLER_ROW(row)                                                                                        \
+    &CPU::executeOpcode<row | 0x0>, &CPU::executeOpcode<row | 0x1>, &CPU::executeOpcode<row | 0x2>,                    \
+    &CPU::executeOpcode<row | 0x3>, &CPU::executeOpcode<row | 0x4>, &CPU::executeOpcode<row | 0x5>,                    \
+    &CPU::executeOpcode<row | 0x6>, &CPU::executeOpcode<row | 0x7>, &CPU::executeOpcode<row | 0x8>,                    \
+    &CPU::executeOpcode<row | 0x9>, &CPU::executeOpcode<row | 0xa>, &CPU::executeOpcode<row | 0xb>,                    \
+    &CPU::executeOpcode<row | 0xc>, &CPU::executeOpcode<row | 0xd>, &CPU::executeOpcode<row | 0xe>,                    \
+    &CPU::executeOpcode<row | 0xf>
+
+const CPU::OpcodeHandler CPU::m_opcodeHandlers[0x100] = {
+    OPCODE_HANDLER_ROW(0x00), OPCODE_HANDLER_ROW(0x10), OPCODE_HANDLER_ROW(0x20), OPCODE_HANDLER_ROW(0x30),
+    OPCODE_HANDLER_ROW(0x40), OPCODE_HANDLER_ROW(0x50), OPCODE_HANDLER_ROW(0x60), OPCODE_HANDLER_ROW(0x70),
+    OPCODE_HANDLER_ROW(0x80), OPCODE_HANDLER_ROW(0x90), OPCODE_HANDLER_ROW(0xa0), OPCODE_HANDLER_ROW(0xb0),
+    OPCODE_HANDLER_ROW(0xc0), OPCODE_HANDLER_ROW(0xd0), OPCODE_HANDLER_ROW(0xe0), OPCODE_HANDLER_ROW(0xf0),
+};
+// clang-format on
+
+#undef OPCODE_HANDLER_ROW
+
+template<OperationImplied Op>
+void CPU::executeImplied()
 {
-    switch (static_cast<OperationImplied>(opcode))
+    switch (Op)
     {
     case NOP:
         break;
@@ -188,7 +406,7 @@ bool CPU::executeImplied(Byte opcode)
         // since r_PC and r_PC + 1 are address of subroutine
         pushStack(static_cast<Byte>((r_PC + 1) >> 8));
         pushStack(static_cast<Byte>(r_PC + 1));
-        r_PC = readAddress(r_PC);
+        r_PC = fetchAddress();
         break;
     case RTS:
         r_PC  = pullStack();
@@ -196,24 +414,16 @@ bool CPU::executeImplied(Byte opcode)
         ++r_PC;
         break;
     case RTI:
-    {
-        Byte flags = pullStack();
-        f_N        = flags & 0x80;
-        f_V        = flags & 0x40;
-        f_D        = flags & 0x8;
-        f_I        = flags & 0x4;
-        f_Z        = flags & 0x2;
-        f_C        = flags & 0x1;
-    }
+        setStatus(pullStack());
         r_PC  = pullStack();
         r_PC |= pullStack() << 8;
         break;
     case JMP:
-        r_PC = readAddress(r_PC);
+        r_PC = fetchAddress();
         break;
     case JMPI:
     {
-        Address location = readAddress(r_PC);
+        Address location = fetchAddress();
         // 6502 has a bug such that the when the vector of anindirect address begins at the last byte of a page,
         // the second byte is fetched from the beginning of that page rather than the beginning of the next
         // Recreating here:
@@ -222,24 +432,12 @@ bool CPU::executeImplied(Byte opcode)
     }
     break;
     case PHP:
-    {
-        Byte flags = f_N << 7 | f_V << 6 | 1 << 5 | // supposed to always be 1
-                     1 << 4 |                       // PHP pushes with the B flag as 1, no matter what
-                     f_D << 3 | f_I << 2 | f_Z << 1 | f_C;
-        pushStack(flags);
-    }
-    break;
+        // PHP pushes with the B flag as 1, no matter what
+        pushStack(getStatus() | 1 << 4);
+        break;
     case PLP:
-    {
-        Byte flags = pullStack();
-        f_N        = flags & 0x80;
-        f_V        = flags & 0x40;
-        f_D        = flags & 0x8;
-        f_I        = flags & 0x4;
-        f_Z        = flags & 0x2;
-        f_C        = flags & 0x1;
-    }
-    break;
+        setStatus(pullStack());
+        break;
     case PHA:
         pushStack(r_A);
         break;
@@ -268,29 +466,29 @@ bool CPU::executeImplied(Byte opcode)
         setZN(r_X);
         break;
     case CLC:
-        f_C = false;
+        m_carry = 0;
         break;
     case SEC:
-        f_C = true;
+        m_carry = 0x100;
         break;
     case CLI:
-        f_I = false;
+        r_P &= ~StatusI;
         break;
     case SEI:
-        f_I = true;
+        r_P |= StatusI;
         break;
     case CLD:
-        f_D = false;
+        r_P &= ~StatusD;
         break;
     case SED:
-        f_D = true;
+        r_P |= StatusD;
         break;
     case TYA:
         r_A = r_Y;
         setZN(r_A);
         break;
     case CLV:
-        f_V = false;
+        r_P &= ~StatusV;
         break;
     case TXA:
         r_A = r_X;
@@ -307,365 +505,324 @@ bool CPU::executeImplied(Byte opcode)
         r_X = r_SP;
         setZN(r_X);
         break;
-    default:
-        return false;
     };
-    return true;
 }
 
-bool CPU::executeBranch(Byte opcode)
+template<BranchOnFlag Flag, bool Condition>
+void CPU::executeBranch()
 {
-    if ((opcode & BranchInstructionMask) == BranchInstructionMaskResult)
-    {
-        // branch is initialized to the condition required (for the flag specified later)
-        bool branch = opcode & BranchConditionMask;
+    // branch is initialized to the condition required (for the flag specified later)
+    bool branch = Condition;
 
-        // set branch to true if the given condition is met by the given flag
-        // We use xnor here, it is true if either both operands are true or false
-        switch (opcode >> BranchOnFlagShift)
-        {
-        case Negative:
-            branch = !(branch ^ f_N);
-            break;
-        case Overflow:
-            branch = !(branch ^ f_V);
-            break;
-        case Carry:
-            branch = !(branch ^ f_C);
-            break;
-        case Zero:
-            branch = !(branch ^ f_Z);
-            break;
-        default:
-            return false;
-        }
+    // set branch to true if the given condition is met by the given flag
+    // We use xnor here, it is true if either both operands are true or false
+    switch (Flag)
+    {
+    case Negative:
+        branch = !(branch ^ getN());
+        break;
+    case Overflow:
+        branch = !(branch ^ bool(r_P & StatusV));
+        break;
+    case Carry:
+        branch = !(branch ^ getC());
+        break;
+    case Zero:
+        branch = !(branch ^ getZ());
+        break;
+    }
 
-        if (branch)
-        {
-            int8_t offset = m_bus.read(r_PC++);
-            // skip 1 cycle since branch is taken
-            ++m_skipCycles;
-            auto newPC = static_cast<Address>(r_PC + offset);
-            // skip 1 additional cycle if page is crossed
-            skipPageCrossCycle(r_PC, newPC);
-            r_PC = newPC;
-        }
-        else
-            ++r_PC;
-        return true;
+    if (branch)
+    {
+        int8_t offset = fetchByte();
+        // skip 1 cycle since branch is taken
+        ++m_skipCycles;
+        auto newPC = static_cast<Address>(r_PC + offset);
+        // skip 1 additional cycle if page is crossed
+        skipPageCrossCycle(r_PC, newPC);
+        r_PC = newPC;
     }
-    return false;
+    else
+        ++r_PC;
 }
 
-bool CPU::executeType1(Byte opcode)
+template<AddrMode1 Mode, Operation1 Op>
+void CPU::executeType1()
 {
-    if ((opcode & InstructionModeMask) == 0x1)
+    Address location = 0; // Location of the operand, could be in RAM
+    switch (Mode)
     {
-        Address location = 0; // Location of the operand, could be in RAM
-        auto    op       = static_cast<Operation1>((opcode & OperationMask) >> OperationShift);
-        switch (static_cast<AddrMode1>((opcode & AddrModeMask) >> AddrModeShift))
-        {
-        case IndexedIndirectX:
-        {
-            Byte zero_addr = r_X + m_bus.read(r_PC++);
-            // Addresses wrap in zero page mode, thus pass through a mask
-            location       = m_bus.read(zero_addr & 0xff) | m_bus.read((zero_addr + 1) & 0xff) << 8;
-        }
+    case IndexedIndirectX:
+    {
+        Byte zero_addr = r_X + fetchByte();
+        // Addresses wrap in zero page mode, thus pass through a mask
+        location       = m_bus.read(zero_addr & 0xff) | m_bus.read((zero_addr + 1) & 0xff) << 8;
+    }
+    break;
+    case ZeroPage:
+        location = fetchByte();
         break;
-        case ZeroPage:
-            location = m_bus.read(r_PC++);
-            break;
-        case Immediate:
-            location = r_PC++;
-            break;
-        case Absolute:
-            location  = readAddress(r_PC);
-            r_PC     += 2;
-            break;
-        case IndirectY:
-        {
-            Byte zero_addr = m_bus.read(r_PC++);
-            location       = m_bus.read(zero_addr & 0xff) | m_bus.read((zero_addr + 1) & 0xff) << 8;
-            if (op != STA)
-                skipPageCrossCycle(location, location + r_Y);
-            location += r_Y;
-        }
+    case Immediate:
+        location = r_PC++;
         break;
-        case IndexedX:
-            // Address wraps around in the zero page
-            location = (m_bus.read(r_PC++) + r_X) & 0xff;
-            break;
-        case AbsoluteY:
-            location  = readAddress(r_PC);
-            r_PC     += 2;
-            if (op != STA)
-                skipPageCrossCycle(location, location + r_Y);
-            location += r_Y;
-            break;
-        case AbsoluteX:
-            location  = readAddress(r_PC);
-            r_PC     += 2;
-            if (op != STA)
-                skipPageCrossCycle(location, location + r_X);
-            location += r_X;
-            break;
-        default:
-            return false;
-        }
+    case Absolute:
+        location  = fetchAddress();
+        break;
+    case IndirectY:
+    {
+        Byte zero_addr = fetchByte();
+        location       = m_bus.read(zero_addr & 0xff) | m_bus.read((zero_addr + 1) & 0xff) << 8;
+        if (Op != STA)
+            skipPageCrossCycle(location, location + r_Y);
+        location += r_Y;
+    }
+    break;
+    case IndexedX:
+        // Address wraps around in the zero page
+        location = (fetchByte() + r_X) & 0xff;
+        break;
+    case AbsoluteY:
+        location  = fetchAddress();
+        if (Op != STA)
+            skipPageCrossCycle(location, location + r_Y);
+        location += r_Y;
+        break;
+    case AbsoluteX:
+        location  = fetchAddress();
+        if (Op != STA)
+            skipPageCrossCycle(location, location + r_X);
+        location += r_X;
+        break;
+    }
 
-        switch (op)
-        {
-        case ORA:
-            r_A |= m_bus.read(location);
-            setZN(r_A);
-            break;
-        case AND:
-            r_A &= m_bus.read(location);
-            setZN(r_A);
-            break;
-        case EOR:
-            r_A ^= m_bus.read(location);
-            setZN(r_A);
-            break;
-        case ADC:
-        {
-            Byte          operand = m_bus.read(location);
-            std::uint16_t sum     = r_A + operand + f_C;
-            // Carry forward or UNSIGNED overflow
-            f_C                   = sum & 0x100;
-            // SIGNED overflow, would only happen if the sign of sum is
-            // different from BOTH the operands
-            f_V                   = (r_A ^ sum) & (operand ^ sum) & 0x80;
-            r_A                   = static_cast<Byte>(sum);
-            setZN(r_A);
-        }
+    switch (Op)
+    {
+    case ORA:
+        r_A |= m_bus.read(location);
+        setZN(r_A);
         break;
-        case STA:
-            m_bus.write(location, r_A);
-            break;
-        case LDA:
-            r_A = m_bus.read(location);
-            setZN(r_A);
-            break;
-        case SBC:
-        {
-            // High carry means "no borrow", thus negate and subtract
-            std::uint16_t subtrahend = m_bus.read(location), diff = r_A - subtrahend - !f_C;
-            // if the ninth bit is 1, the resulting number is negative => borrow => low carry
-            f_C = !(diff & 0x100);
-            // Same as ADC, except instead of the subtrahend,
-            // substitute with it's one complement
-            f_V = (r_A ^ diff) & (~subtrahend ^ diff) & 0x80;
-            r_A = diff;
-            setZN(diff);
-        }
+    case AND:
+        r_A &= m_bus.read(location);
+        setZN(r_A);
         break;
-        case CMP:
-        {
-            std::uint16_t diff = r_A - m_bus.read(location);
-            f_C                = !(diff & 0x100);
-            setZN(diff);
-        }
+    case EOR:
+        r_A ^= m_bus.read(location);
+        setZN(r_A);
         break;
-        default:
-            return false;
-        }
-        return true;
+    case ADC:
+    {
+        Byte          operand = m_bus.read(location);
+        std::uint16_t sum     = r_A + operand + getC();
+        // Carry forward or UNSIGNED overflow
+        m_carry               = sum;
+        // SIGNED overflow, would only happen if the sign of sum is
+        // different from BOTH the operands
+        r_P                   = (r_P & ~StatusV) | ((r_A ^ sum) & (operand ^ sum) & 0x80) >> 1;
+        r_A                   = static_cast<Byte>(sum);
+        setZN(r_A);
+    }
+    break;
+    case STA:
+        m_bus.write(location, r_A);
+        break;
+    case LDA:
+        r_A = m_bus.read(location);
+        setZN(r_A);
+        break;
+    case SBC:
+    {
+        // High carry means "no borrow", thus negate and subtract
+        std::uint16_t subtrahend = m_bus.read(location), diff = r_A - subtrahend - !getC();
+        // if the ninth bit is 1, the resulting number is negative => borrow => low carry
+        m_carry = diff ^ 0x100;
+        // Same as ADC, except instead of the subtrahend,
+        // substitute with it's one complement
+        r_P     = (r_P & ~StatusV) | ((r_A ^ diff) & (~subtrahend ^ diff) & 0x80) >> 1;
+        r_A     = diff;
+        setZN(diff);
+    }
+    break;
+    case CMP:
+    {
+        std::uint16_t diff = r_A - m_bus.read(location);
+        m_carry            = diff ^ 0x100;
+        setZN(diff);
+    }
+    break;
     }
-    return false;
 }
 
-bool CPU::executeType2(Byte opcode)
+template<AddrMode2 Mode, Operation2 Op>
+void CPU::executeType2()
 {
-    if ((opcode & InstructionModeMask) == 2)
+    Address location = 0;
+    switch (Mode)
     {
-        Address location  = 0;
-        auto    op        = static_cast<Operation2>((opcode & OperationMask) >> OperationShift);
-        auto    addr_mode = static_cast<AddrMode2>((opcode & AddrModeMask) >> AddrModeShift);
-        switch (addr_mode)
-        {
-        case Immediate_:
-            location = r_PC++;
-            break;
-        case ZeroPage_:
-            location = m_bus.read(r_PC++);
-            break;
-        case Accumulator:
-            break;
-        case Absolute_:
-            location  = readAddress(r_PC);
-            r_PC     += 2;
-            break;
-        case Indexed:
-        {
-            location = m_bus.read(r_PC++);
-            Byte index;
-            if (op == LDX || op == STX)
-                index = r_Y;
-            else
-                index = r_X;
-            // The mask wraps address around zero page
-            location = (location + index) & 0xff;
-        }
+    case Immediate_:
+        location = r_PC++;
         break;
-        case AbsoluteIndexed:
-        {
-            location  = readAddress(r_PC);
-            r_PC     += 2;
-            Byte index;
-            if (op == LDX || op == STX)
-                index = r_Y;
-            else
-                index = r_X;
-            skipPageCrossCycle(location, location + index);
-            location += index;
-        }
+    case ZeroPage_:
+        location = fetchByte();
         break;
-        default:
-            return false;
-        }
+    case Accumulator:
+        break;
+    case Absolute_:
+        location  = fetchAddress();
+        break;
+    case Indexed:
+    {
+        location = fetchByte();
+        Byte index;
+        if (Op == LDX || Op == STX)
+            index = r_Y;
+        else
+            index = r_X;
+        // The mask wraps address around zero page
+        location = (location + index) & 0xff;
+    }
+    break;
+    case AbsoluteIndexed:
+    {
+        location  = fetchAddress();
+        Byte index;
+        if (Op == LDX || Op == STX)
+            index = r_Y;
+        else
+            index = r_X;
+        skipPageCrossCycle(location, location + index);
+        location += index;
+    }
+    break;
+    }
 
-        std::uint16_t operand = 0;
-        switch (op)
+    std::uint16_t operand = 0;
+    switch (Op)
+    {
+    case ASL:
+    case ROL:
+        if (Mode == Accumulator)
         {
-        case ASL:
-        case ROL:
-            if (addr_mode == Accumulator)
-            {
-                auto prev_C   = f_C;
-                f_C           = r_A & 0x80;
-                r_A         <<= 1;
-                // If Rotating, set the bit-0 to the the previous carry
-                r_A           = r_A | (prev_C && (op == ROL));
-                setZN(r_A);
-            }
-            else
-            {
-                auto prev_C = f_C;
-                operand     = m_bus.read(location);
-                f_C         = operand & 0x80;
-                operand     = operand << 1 | (prev_C && (op == ROL));
-                setZN(operand);
-                m_bus.write(location, operand);
-            }
-            break;
-        case LSR:
-        case ROR:
-            if (addr_mode == Accumulator)
-            {
-                auto prev_C   = f_C;
-                f_C           = r_A & 1;
-                r_A         >>= 1;
-                // If Rotating, set the bit-7 to the previous carry
-                r_A           = r_A | (prev_C && (op == ROR)) << 7;
-                setZN(r_A);
-            }
-            else
-            {
-                auto prev_C = f_C;
-                operand     = m_bus.read(location);
-                f_C         = operand & 1;
-                operand     = operand >> 1 | (prev_C && (op == ROR)) << 7;
-                setZN(operand);
-                m_bus.write(location, operand);
-            }
-            break;
-        case STX:
-            m_bus.write(location, r_X);
-            break;
-        case LDX:
-            r_X = m_bus.read(location);
-            setZN(r_X);
-            break;
-        case DEC:
+            auto prev_C   = getC();
+            m_carry       = r_A << 1;
+            r_A         <<= 1;
+            // If Rotating, set the bit-0 to the the previous carry
+            r_A           = r_A | (prev_C && (Op == ROL));
+            setZN(r_A);
+        }
+        else
         {
-            auto tmp = m_bus.read(location) - 1;
-            setZN(tmp);
-            m_bus.write(location, tmp);
+            auto prev_C = getC();
+            operand     = m_bus.read(location);
+            m_carry     = operand << 1;
+            operand     = operand << 1 | (prev_C && (Op == ROL));
+            setZN(operand);
+            m_bus.write(location, operand);
         }
         break;
-        case INC:
+    case LSR:
+    case ROR:
+        if (Mode == Accumulator)
         {
-            auto tmp = m_bus.read(location) + 1;
-            setZN(tmp);
-            m_bus.write(location, tmp);
+            auto prev_C   = getC();
+            m_carry       = r_A << 8;
+            r_A         >>= 1;
+            // If Rotating, set the bit-7 to the previous carry
+            r_A           = r_A | (prev_C && (Op == ROR)) << 7;
+            setZN(r_A);
         }
-        break;
-        default:
-            return false;
+        else
+        {
+            auto prev_C = getC();
+            operand     = m_bus.read(location);
+            m_carry     = operand << 8;
+            operand     = operand >> 1 | (prev_C && (Op == ROR)) << 7;
+            setZN(operand);
+            m_bus.write(location, operand);
         }
-        return true;
+        break;
+    case STX:
+        m_bus.write(location, r_X);
+        break;
+    case LDX:
+        r_X = m_bus.read(location);
+        setZN(r_X);
+        break;
+    case DEC:
+    {
+        auto tmp = m_bus.read(location) - 1;
+        setZN(tmp);
+        m_bus.write(location, tmp);
+    }
+    break;
+    case INC:
+    {
+        auto tmp = m_bus.read(location) + 1;
+        setZN(tmp);
+        m_bus.write(location, tmp);
+    }
+    break;
     }
-    return false;
 }
 
-bool CPU::executeType0(Byte opcode)
+template<AddrMode2 Mode, Operation0 Op>
+void CPU::executeType0()
 {
-    if ((opcode & InstructionModeMask) == 0x0)
+    Address location = 0;
+    switch (Mode)
     {
-        Address location = 0;
-        switch (static_cast<AddrMode2>((opcode & AddrModeMask) >> AddrModeShift))
-        {
-        case Immediate_:
-            location = r_PC++;
-            break;
-        case ZeroPage_:
-            location = m_bus.read(r_PC++);
-            break;
-        case Absolute_:
-            location  = readAddress(r_PC);
-            r_PC     += 2;
-            break;
-        case Indexed:
-            // Address wraps around in the zero page
-            location = (m_bus.read(r_PC++) + r_X) & 0xff;
-            break;
-        case AbsoluteIndexed:
-            location  = readAddress(r_PC);
-            r_PC     += 2;
-            skipPageCrossCycle(location, location + r_X);
-            location += r_X;
-            break;
-        default:
-            return false;
-        }
-        std::uint16_t operand = 0;
-        switch (static_cast<Operation0>((opcode & OperationMask) >> OperationShift))
-        {
-        case BIT:
-            operand = m_bus.read(location);
-            f_Z     = !(r_A & operand);
-            f_V     = operand & 0x40;
-            f_N     = operand & 0x80;
-            break;
-        case STY:
-            m_bus.write(location, r_Y);
-            break;
-        case LDY:
-            r_Y = m_bus.read(location);
-            setZN(r_Y);
-            break;
-        case CPY:
-        {
-            std::uint16_t diff = r_Y - m_bus.read(location);
-            f_C                = !(diff & 0x100);
-            setZN(diff);
-        }
+    case Immediate_:
+        location = r_PC++;
         break;
-        case CPX:
-        {
-            std::uint16_t diff = r_X - m_bus.read(location);
-            f_C                = !(diff & 0x100);
-            setZN(diff);
-        }
+    case ZeroPage_:
+        location = fetchByte();
         break;
-        default:
-            return false;
-        }
+    case Absolute_:
+        location  = fetchAddress();
+        break;
+    case Indexed:
+        // Address wraps around in the zero page
+        location = (fetchByte() + r_X) & 0xff;
+        break;
+    case AbsoluteIndexed:
+        location  = fetchAddress();
+        skipPageCrossCycle(location, location + r_X);
+        location += r_X;
+        break;
+    default:
+        break;
+    }
 
-        return true;
+    std::uint16_t operand = 0;
+    switch (Op)
+    {
+    case BIT:
+        operand      = m_bus.read(location);
+        // N comes from the operand rather than the result, kept apart in the ninth bit
+        m_lastResult = (r_A & operand) | (operand & 0x80) << 1;
+        r_P          = (r_P & ~StatusV) | (operand & StatusV);
+        break;
+    case STY:
+        m_bus.write(location, r_Y);
+        break;
+    case LDY:
+        r_Y = m_bus.read(location);
+        setZN(r_Y);
+        break;
+    case CPY:
+    {
+        std::uint16_t diff = r_Y - m_bus.read(location);
+        m_carry            = diff ^ 0x100;
+        setZN(diff);
+    }
+    break;
+    case CPX:
+    {
+        std::uint16_t diff = r_X - m_bus.read(location);
+        m_carry            = diff ^ 0x100;
+        setZN(diff);
+    }
+    break;
     }
-    return false;
 }
 
 Address CPU::readAddress(Address addr)
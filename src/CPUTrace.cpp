@@ -0,0 +1,113 @@
+#include "CPUTrace.h"
+#include "Log.h"
+#include <cstring>
+#include <iomanip>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace sn
+{
+CPUTraceRecorder::CPUTraceRecorder()
+  : m_header(nullptr)
+  , m_records(nullptr)
+  , m_index(0)
+  , m_size(0)
+#ifdef _WIN32
+  , m_file(INVALID_HANDLE_VALUE)
+  , m_mapping(nullptr)
+#endif
+{
+}
+
+CPUTraceRecorder::~CPUTraceRecorder()
+{
+    close();
+}
+
+bool CPUTraceRecorder::open(const std::string& path, std::uint32_t capacity)
+{
+    close();
+    if (capacity == 0)
+    {
+        LOG(Error) << "CPU trace needs room for at least one record" << std::endl;
+        return false;
+    }
+
+    m_size     = sizeof(CPUTraceHeader) + std::size_t(capacity) * sizeof(CPUTraceRecord);
+    void* data = nullptr;
+#ifdef _WIN32
+    m_file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS,
+                         FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_file != INVALID_HANDLE_VALUE)
+        m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READWRITE, DWORD(std::uint64_t(m_size) >> 32),
+                                       DWORD(m_size), nullptr);
+    if (m_mapping)
+        data = MapViewOfFile(m_mapping, FILE_MAP_WRITE, 0, 0, m_size);
+#else
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0 && ftruncate(fd, m_size) == 0)
+    {
+        data = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED)
+            data = nullptr;
+    }
+    // The mapping keeps the file open
+    if (fd >= 0)
+        ::close(fd);
+#endif
+
+    if (!data)
+    {
+        LOG(Error) << "Could not map the CPU trace file: " << path << std::endl;
+        close();
+        return false;
+    }
+
+    m_header  = static_cast<CPUTraceHeader*>(data);
+    m_records = reinterpret_cast<CPUTraceRecord*>(m_header + 1);
+    m_index   = 0;
+    std::memcpy(m_header->magic, CPUTraceMagic, sizeof(CPUTraceMagic));
+    m_header->recordSize = sizeof(CPUTraceRecord);
+    m_header->capacity   = capacity;
+    m_header->written    = 0;
+    LOG(Info) << "Tracing the CPU to " << path << ", " << capacity << " records" << std::endl;
+    return true;
+}
+
+void CPUTraceRecorder::close()
+{
+#ifdef _WIN32
+    if (m_header)
+        UnmapViewOfFile(m_header);
+    if (m_mapping)
+        CloseHandle(m_mapping);
+    if (m_file != INVALID_HANDLE_VALUE)
+        CloseHandle(m_file);
+    m_mapping = nullptr;
+    m_file    = INVALID_HANDLE_VALUE;
+#else
+    if (m_header)
+        munmap(m_header, m_size);
+#endif
+    m_header  = nullptr;
+    m_records = nullptr;
+}
+
+std::ostream& operator<<(std::ostream& out, const CPUTraceRecord& record)
+{
+    return out << std::hex << std::setfill('0') << std::uppercase << std::setw(4) << +record.pc << "  "
+               << std::setw(2) << +record.opcode << "  "
+               << "A:" << std::setw(2) << +record.a << " "
+               << "X:" << std::setw(2) << +record.x << " "
+               << "Y:" << std::setw(2) << +record.y << " "
+               << "P:" << std::setw(2) << +record.p << " "
+               << "SP:" << std::setw(2) << +record.sp << " "
+               << "CYC:" << std::setw(3) << std::setfill(' ') << std::dec << record.dot;
+}
+}
@@ -3,7 +3,8 @@
 namespace sn
 {
 Controller::Controller()
-  : m_keyStates(0)
+  : m_strobe(false)
+  , m_keyStates(0)
   , m_keyBindings(TotalButtons)
 {
     //         m_keyBindings[A] = sf::Keyboard::J;
@@ -36,6 +37,11 @@ void Controller::strobe(Byte b)
     }
 }
 
+void Controller::snapshot(Snapshot& state)
+{
+    state(m_strobe, m_keyStates);
+}
+
 Byte Controller::read()
 {
     Byte ret;
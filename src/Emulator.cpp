@@ -2,22 +2,67 @@
 #include "APU/Constants.h"
 #include "Log.h"
 
+#include <algorithm>
 #include <chrono>
+#include <fstream>
+#include <thread>
 
 namespace sn
 {
 using std::chrono::high_resolution_clock;
 
+namespace
+{
+    // The system may oversleep, so it sleeps until shortly before the deadline and spins the rest of the way
+    void sleepUntil(TimePoint deadline)
+    {
+        const auto spin  = std::chrono::milliseconds(1);
+        const auto sleep = deadline - spin - high_resolution_clock::now();
+        if (sleep > Duration::zero())
+            sf::sleep(sf::microseconds(std::chrono::duration_cast<std::chrono::microseconds>(sleep).count()));
+        while (high_resolution_clock::now() < deadline)
+            std::this_thread::yield();
+    }
+}
+
 Emulator::Emulator()
   : m_cpu(m_bus)
+  , m_frameSkip(0)
+  , m_autoFrameSkip(false)
+  , m_renderThread(false)
+  , m_audioSync(false)
+  , m_frameLoop(false)
+  , m_fastForwardSpeed(0)
+  , m_fastForwardAlways(false)
+  , m_runAheadFrames(0)
   , m_audioPlayer(static_cast<int>(1.0 / apu_clock_period_s.count()))
   , m_ppu(m_pictureBus, m_emulatorScreen)
   , m_apu(m_audioPlayer, m_cpu.createIRQHandler(), [&](Address addr) { return DMCDMA(addr); })
   , m_bus(m_ppu, m_apu, m_controller1, m_controller2, [&](Byte b) { OAMDMA(b); })
+  , m_renderer(m_emulatorScreen)
   , m_screenScale(3.f)
+  , m_running(false)
+  , m_focus(true)
+  , m_paused(false)
+  , m_frameSteps(0)
+  , m_profileRequested(false)
+  , m_fastForwardHeld(false)
   , m_lastWakeup()
+  , m_frames(0)
+  , m_missedDeadlines(0)
+  , m_targetCycle(0)
+  , m_ppuCycles(0)
+  , m_ppuInterruptCycle(0)
 {
     m_ppu.setInterruptCallback([&]() { m_cpu.nmiInterrupt(); });
+    m_bus.setSyncCallback(
+        [&]()
+        {
+            // The instruction being run sees the PPU as it is during its first cycle
+            catchUpPPU(m_cpu.getCycles() + 1);
+            // A register write can change when the next interrupt is, so check again before the next instruction
+            m_ppuInterruptCycle = 0;
+        });
 }
 
 void Emulator::run(std::string rom_path)
@@ -42,6 +87,13 @@ void Emulator::run(std::string rom_path)
 
     m_cpu.reset();
     m_ppu.reset();
+    if (m_renderThread && m_runAheadFrames)
+    {
+        LOG(Error) << "The render thread can't take frames back, drawing on the emulation thread for run-ahead"
+                   << std::endl;
+    }
+    else if (m_renderThread)
+        startRenderThread();
 
     m_window.create(sf::VideoMode(NESVideoWidth * m_screenScale, NESVideoHeight * m_screenScale),
                     "SimpleNES",
@@ -49,13 +101,19 @@ void Emulator::run(std::string rom_path)
     m_window.setVerticalSyncEnabled(true);
     m_emulatorScreen.create(NESVideoWidth, NESVideoHeight, m_screenScale, sf::Color::White);
 
-    m_lastWakeup  = high_resolution_clock::now();
-    m_elapsedTime = m_lastWakeup - m_lastWakeup;
+    if (m_audioSync)
+        m_audioPlayer.enableRateControl();
+    if (!m_audioPlayer.start() && m_audioSync)
+    {
+        LOG(Error) << "No audio device to sync to, pacing by the system clock" << std::endl;
+        m_audioSync = false;
+    }
 
-    m_audioPlayer.start();
+    // The emulation runs on a thread of its own, this one handles the window and shows the frames it finishes
+    m_running = true;
+    std::thread emulation(&Emulator::emulate, this);
 
     sf::Event event;
-    bool      focus = true, pause = false;
     while (m_window.isOpen())
     {
         while (m_window.pollEvent(event))
@@ -63,89 +121,326 @@ void Emulator::run(std::string rom_path)
             if (event.type == sf::Event::Closed ||
                 (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Escape))
             {
+                m_running = false;
+                emulation.join();
                 m_window.close();
+                writeProfile();
+                if (m_frameLoop)
+                {
+                    LOG(Info) << "Missed " << m_missedDeadlines << " of " << m_frames << " frame deadlines"
+                              << std::endl;
+                }
                 return;
             }
             else if (event.type == sf::Event::GainedFocus)
             {
-                focus          = true;
-                const auto now = high_resolution_clock::now();
-                LOG(Info) << "Gained focus. Removing " << (now - m_lastWakeup).count() << "ns from timers" << std::endl;
-                m_lastWakeup = now;
+                m_focus = true;
+                LOG(Info) << "Gained focus." << std::endl;
             }
             else if (event.type == sf::Event::LostFocus)
             {
-                focus = false;
+                m_focus = false;
+                // The release of a held Tab would go to the window that took the focus
+                m_fastForwardHeld = false;
                 LOG(Info) << "Losing focus; paused." << std::endl;
             }
             else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F2)
             {
-                pause = !pause;
-                if (!pause)
-                {
-                    const auto now = high_resolution_clock::now();
-                    LOG(Info) << "Unpaused. Removing " << (now - m_lastWakeup).count() << "ns from timers" << std::endl;
-                    m_lastWakeup = now;
-                }
-                else
-                {
-                    LOG(Info) << "Paused." << std::endl;
-                }
+                m_paused = !m_paused;
+                LOG(Info) << (m_paused ? "Paused." : "Unpaused.") << std::endl;
             }
-            else if (pause && event.type == sf::Event::KeyReleased && event.key.code == sf::Keyboard::F3)
+            else if (m_paused && event.type == sf::Event::KeyReleased && event.key.code == sf::Keyboard::F3)
             {
-                for (int i = 0; i < 29781; ++i) // Around one frame
-                {
-                    // PPU
-                    m_ppu.step();
-                    m_ppu.step();
-                    m_ppu.step();
-                    // CPU
-                    m_cpu.step();
-                    // APU
-                    m_apu.step();
-                }
+                ++m_frameSteps;
             }
-            else if (focus && event.type == sf::Event::KeyReleased && event.key.code == sf::Keyboard::F4)
+            else if (m_focus && event.type == sf::Event::KeyReleased && event.key.code == sf::Keyboard::F4)
             {
                 Log::get().setLevel(Info);
             }
-            else if (focus && event.type == sf::Event::KeyReleased && event.key.code == sf::Keyboard::F5)
+            else if (m_focus && event.type == sf::Event::KeyReleased && event.key.code == sf::Keyboard::F5)
             {
                 Log::get().setLevel(InfoVerbose);
             }
-        }
-
-        if (focus && !pause)
-        {
-            const auto now  = high_resolution_clock::now();
-            m_elapsedTime  += now - m_lastWakeup;
-            m_lastWakeup    = now;
-
-            while (m_elapsedTime > cpu_clock_period_ns)
+            else if (event.type == sf::Event::KeyReleased && event.key.code == sf::Keyboard::F6)
+            {
+                m_profileRequested = true;
+            }
+            else if (m_focus && event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Tab)
             {
-                // PPU
-                m_ppu.step();
-                m_ppu.step();
-                m_ppu.step();
-                // CPU
-                m_cpu.step();
-                // APU
-                m_apu.step();
-
-                m_elapsedTime -= cpu_clock_period_ns;
+                m_fastForwardHeld = true;
             }
+            else if (event.type == sf::Event::KeyReleased && event.key.code == sf::Keyboard::Tab)
+            {
+                m_fastForwardHeld = false;
+            }
+        }
 
+        // Only new frames are drawn, the wait for vsync doesn't hold up the emulation anymore
+        if (m_emulatorScreen.update())
+        {
             m_window.draw(m_emulatorScreen);
             m_window.display();
         }
         else
         {
+            sf::sleep(sf::milliseconds(1));
+        }
+    }
+}
+
+void Emulator::emulate()
+{
+    const auto frameDuration = CPUFrameCycles * cpu_clock_period_ns;
+
+    m_lastWakeup  = high_resolution_clock::now();
+    m_elapsedTime = Duration::zero();
+    while (m_running)
+    {
+        if (m_profileRequested.exchange(false))
+            writeProfile();
+
+        if (!m_focus || m_paused)
+        {
+            for (; m_frameSteps > 0; --m_frameSteps)
+                runCycles(CPUFrameCycles);
             sf::sleep(sf::milliseconds(1000 / 60));
+            // The time spent paused is not caught up on
+            m_lastWakeup = high_resolution_clock::now();
+            continue;
         }
+
+        // Only the pacing changes when fast-forwarding, the audio device keeps going
+        const int speed = m_fastForwardHeld || m_fastForwardAlways ? m_fastForwardSpeed : 1;
+        if (speed)
+            m_apu.setSampleDecimation(speed);
+
+        // The clocks drifting apart is taken care of by the audio rate control, this only keeps the emulation from
+        // running off when it is too far ahead for that
+        if (m_audioSync && speed == 1 && m_audioPlayer.isQueueFull())
+        {
+            sf::sleep(sf::milliseconds(1));
+            m_lastWakeup = high_resolution_clock::now();
+            continue;
+        }
+
+        if (m_frameLoop || !speed || m_runAheadFrames)
+        {
+            runFrame(speed);
+            continue;
+        }
+
+        const auto now  = high_resolution_clock::now();
+        m_elapsedTime  += (now - m_lastWakeup) * speed;
+        m_lastWakeup    = now;
+
+        const auto cycles  = m_elapsedTime / cpu_clock_period_ns;
+        // Behind real time, the frames before the last complete one to be run won't be shown anyway
+        if (m_autoFrameSkip && cycles > 2 * CPUFrameCycles)
+        {
+            const auto skipped = cycles - 2 * CPUFrameCycles;
+            skipFrames(-1);
+            runCycles(skipped);
+            skipFrames(m_frameSkip);
+            runCycles(cycles - skipped);
+        }
+        else
+            runCycles(cycles);
+        m_elapsedTime     -= cycles * cpu_clock_period_ns;
+
+        // Wake up when about a frame is due
+        std::this_thread::sleep_for((frameDuration - m_elapsedTime) / speed);
     }
 }
 
+void Emulator::runFrame(int speed)
+{
+    const auto frameDuration = CPUFrameCycles * cpu_clock_period_ns;
+
+    const auto start = high_resolution_clock::now();
+    if (m_runAheadFrames)
+        runAhead();
+    else
+        runCycles(CPUFrameCycles);
+    ++m_frames;
+
+    if (!speed)
+    {
+        // As fast as possible, the audio is decimated by how many frames run in the time of one
+        const auto took = std::max<Duration>(high_resolution_clock::now() - start, std::chrono::nanoseconds(1));
+        m_apu.setSampleDecimation(std::max<int>(frameDuration / took, 1));
+        m_lastWakeup = high_resolution_clock::now();
+        return;
+    }
+
+    // m_lastWakeup is when the frame was due, the next one is due a frame later
+    m_lastWakeup     += frameDuration / speed;
+    const auto now    = high_resolution_clock::now();
+    const bool missed = now > m_lastWakeup;
+    if (missed)
+    {
+        ++m_missedDeadlines;
+        if (m_missedDeadlines % 60 == 1)
+        {
+            LOG(Info) << "Missed " << m_missedDeadlines << " of " << m_frames << " frame deadlines" << std::endl;
+        }
+        // More than a frame late, the time is lost rather than caught up on
+        if (now - m_lastWakeup > frameDuration / speed)
+            m_lastWakeup = now;
+    }
+    else
+        sleepUntil(m_lastWakeup);
+
+    // The frame after a missed deadline isn't drawn
+    if (m_autoFrameSkip && !m_runAheadFrames)
+        skipFrames(missed ? -1 : m_frameSkip);
+}
+
+void Emulator::runCycles(int cycles)
+{
+    m_targetCycle += cycles;
+    while (m_cpu.getCycles() < m_targetCycle)
+    {
+        auto cycle = m_cpu.getCycles();
+        // An instruction sees interrupts raised up to and including its first cycle
+        if (cycle >= m_ppuInterruptCycle)
+            catchUpPPU(cycle + 1);
+
+        m_cpu.step();
+
+        // DMC DMA can stall the CPU from here, which pushes its cycle count further
+        for (; cycle < m_cpu.getCycles(); ++cycle)
+            m_apu.step();
+
+        if (m_cpu.isInIdleLoop())
+            skipIdleLoop();
+    }
+
+    catchUpPPU(m_cpu.getCycles());
+    if (m_renderer.isRunning())
+        m_renderer.submit(3 * m_ppuCycles);
+}
+
+void Emulator::catchUpPPU(std::uint64_t cycle)
+{
+    if (m_ppuCycles < cycle)
+    {
+        m_ppu.step(static_cast<int>(3 * (cycle - m_ppuCycles)));
+        m_ppuCycles = cycle;
+    }
+
+    // The interrupt can only happen during the cycle of its step
+    m_ppuInterruptCycle = m_ppuCycles + (m_ppu.stepsUntilInterrupt() - 1) / 3;
+}
+
+void Emulator::skipIdleLoop()
+{
+    catchUpPPU(m_cpu.getCycles());
+
+    // The loop can only end when an interrupt comes in or, if it polls PPUSTATUS, when the status changes
+    auto limit = std::min(m_ppuInterruptCycle, m_targetCycle);
+    if (m_cpu.idleLoopPollsStatus())
+        limit = std::min(limit, m_ppuCycles + (m_ppu.stepsUntilStatusChange() - 1) / 3);
+
+    // The APU's interrupts can't be foreseen, and one raised within an iteration would only be seen at its end,
+    // after the wrong instruction. So the loop runs normally while the CPU would take them
+    if (m_cpu.acceptsIRQ() && m_apu.canInterrupt())
+        limit = m_cpu.getCycles();
+
+    // Otherwise the APU is only stepped along, for its sound
+    auto cycle = m_cpu.getCycles();
+    while (m_cpu.skipIdleIteration(limit))
+    {
+        for (; cycle < m_cpu.getCycles(); ++cycle)
+            m_apu.step();
+    }
+}
+
+void Emulator::writeProfile()
+{
+    if (m_profilePath.empty())
+        return;
+
+    std::ofstream file(m_profilePath);
+    if (!file)
+    {
+        LOG(Error) << "Could not write the profile to " << m_profilePath << std::endl;
+        return;
+    }
+    m_profiler.report(file);
+    LOG(Info) << "Wrote the profile to " << m_profilePath << std::endl;
+}
+
+void Emulator::startRenderThread()
+{
+    if (!m_renderer.start(m_cartridge, static_cast<Mapper::Type>(m_cartridge.getMapper())))
+    {
+        LOG(Error) << "Starting the render thread failed, drawing on the emulation thread" << std::endl;
+        return;
+    }
+
+    // The emulated PPU only runs the logic from now on, everything that changes what it would draw is journaled
+    m_renderer.setFrameSkip(0, m_frameSkip);
+    m_ppu.setFrameSkip(-1);
+    m_bus.setJournalCallback([&](Address addr, int value) { m_renderer.access(3 * m_ppuCycles, addr, value); });
+}
+
+void Emulator::skipFrames(int frames)
+{
+    if (m_renderer.isRunning())
+        m_renderer.setFrameSkip(3 * m_ppuCycles, frames);
+    else
+        m_ppu.setFrameSkip(frames);
+}
+
+void Emulator::runAhead()
+{
+    // The frame is heard but not seen
+    m_ppu.setFrameSkip(-1);
+    runToFrameEnd();
+
+    m_runAheadState.beginSave();
+    snapshot(m_runAheadState);
+
+    // What is seen is the last frame ahead, none of them is heard, traced or profiled
+    const auto recorder = m_cpu.getTraceRecorder();
+    const auto profiler = m_cpu.getProfiler();
+    m_cpu.setTraceRecorder(nullptr);
+    m_cpu.setProfiler(nullptr);
+    m_apu.setOutputEnabled(false);
+    for (int frame = 1; frame <= m_runAheadFrames; ++frame)
+    {
+        m_ppu.setFrameSkip(frame < m_runAheadFrames ? -1 : 0);
+        runToFrameEnd();
+    }
+    m_apu.setOutputEnabled(true);
+
+    m_runAheadState.beginRestore();
+    snapshot(m_runAheadState);
+    m_ppu.setFrameSkip(m_frameSkip);
+    m_cpu.setTraceRecorder(recorder);
+    m_cpu.setProfiler(profiler);
+}
+
+void Emulator::runToFrameEnd()
+{
+    const auto frame = m_ppu.getFrameCount();
+    while (m_ppu.getFrameCount() == frame)
+        runCycles((m_ppu.stepsUntilFrameEnd() + 2) / 3);
+}
+
+void Emulator::snapshot(Snapshot& state)
+{
+    m_cpu.snapshot(state);
+    m_ppu.snapshot(state);
+    m_apu.snapshot(state);
+    m_bus.snapshot(state);
+    m_pictureBus.snapshot(state);
+    m_mapper->snapshot(state);
+    m_controller1.snapshot(state);
+    m_controller2.snapshot(state);
+    state(m_targetCycle, m_ppuCycles, m_ppuInterruptCycle);
+}
+
 void Emulator::OAMDMA(Byte page)
 {
     m_cpu.skipOAMDMACycles();
@@ -153,6 +448,8 @@ void Emulator::OAMDMA(Byte page)
     if (page_ptr != nullptr)
     {
         m_ppu.doDMA(page_ptr);
+        if (m_renderer.isRunning())
+            m_renderer.dma(3 * m_ppuCycles, page_ptr);
     }
     else
     {
@@ -192,6 +489,64 @@ void Emulator::setKeys(std::vector<sf::Keyboard::Key>& p1, std::vector<sf::Keybo
     m_controller2.setKeyBindings(p2);
 }
 
+void Emulator::skipIdleLoops()
+{
+    m_cpu.setIdleLoopSkipping(true);
+}
+
+void Emulator::traceCPU(const std::string& path, std::uint32_t records)
+{
+    if (m_cpuTrace.open(path, records))
+        m_cpu.setTraceRecorder(&m_cpuTrace);
+}
+
+void Emulator::profile(const std::string& path)
+{
+    m_profilePath = path;
+    m_cpu.setProfiler(&m_profiler);
+}
+
+void Emulator::setFrameSkip(int frames)
+{
+    m_frameSkip = frames;
+    m_ppu.setFrameSkip(frames);
+}
+
+void Emulator::autoFrameSkip()
+{
+    m_autoFrameSkip = true;
+}
+
+void Emulator::renderOnThread()
+{
+    m_renderThread = true;
+}
+
+void Emulator::syncToAudio()
+{
+    m_audioSync = true;
+}
+
+void Emulator::runByFrames()
+{
+    m_frameLoop = true;
+}
+
+void Emulator::setFastForwardSpeed(int speed)
+{
+    m_fastForwardSpeed = speed;
+}
+
+void Emulator::fastForward()
+{
+    m_fastForwardAlways = true;
+}
+
+void Emulator::setRunAhead(int frames)
+{
+    m_runAheadFrames = frames;
+}
+
 void Emulator::muteAudio()
 {
     m_audioPlayer.mute();
@@ -31,13 +31,13 @@ void Log::setCpuTraceStream(std::ostream& stream)
 
 Log& Log::setLevel(Level level)
 {
-    m_logLevel = level;
+    m_logLevel.store(level, std::memory_order_relaxed);
     return *this;
 }
 
 Level Log::getLevel()
 {
-    return m_logLevel;
+    return m_logLevel.load(std::memory_order_relaxed);
 }
 
 TeeBuf::TeeBuf(std::streambuf* sb1, std::streambuf* sb2)
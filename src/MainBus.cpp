@@ -9,11 +9,20 @@ MainBus::MainBus(PPU& ppu, APU& apu, Controller& ctrl1, Controller& ctrl2, std::
   : m_RAM(0x800, 0)
   , m_dmaCallback(dma)
   , m_mapper(nullptr)
+  , m_statusReads(0)
+  , m_registerReads(0)
   , m_ppu(ppu)
   , m_apu(apu)
   , m_controller1(ctrl1)
   , m_controller2(ctrl2)
 {
+    m_readPages.fill(nullptr);
+    m_writePages.fill(nullptr);
+    // 0x800 of RAM mirrored up to 0x2000
+    for (int page = 0; page < 0x20; ++page)
+    {
+        m_readPages[page] = m_writePages[page] = &m_RAM[(page << 8) & 0x7ff];
+    }
 }
 
 Address normalize_mirror(Address addr)
@@ -28,7 +37,7 @@ Address normalize_mirror(Address addr)
     return addr;
 }
 
-Byte MainBus::read(Address addr)
+Byte MainBus::readIO(Address addr)
 {
     if (addr < 0x2000)
     {
@@ -36,7 +45,14 @@ Byte MainBus::read(Address addr)
     }
     else if (addr < 0x4020) // memory-mapped registers
     {
+        m_syncCallback();
         addr = normalize_mirror(addr);
+        if (addr == PPU_STATUS)
+            ++m_statusReads;
+        else
+            ++m_registerReads;
+        if (m_journalCallback && (addr == PPU_STATUS || addr == PPU_DATA))
+            m_journalCallback(addr, -1);
         switch (addr)
         {
         case PPU_STATUS:
@@ -83,7 +99,7 @@ Byte MainBus::read(Address addr)
     }
 }
 
-void MainBus::write(Address addr, Byte value)
+void MainBus::writeIO(Address addr, Byte value)
 {
     if (addr < 0x2000)
     {
@@ -91,7 +107,10 @@ void MainBus::write(Address addr, Byte value)
     }
     else if (addr < 0x4020) // memory-mapped registers
     {
+        m_syncCallback();
         addr = normalize_mirror(addr);
+        if (m_journalCallback && addr <= PPU_DATA)
+            m_journalCallback(addr, value);
         switch (addr)
         {
         case PPU_CTRL:
@@ -153,7 +172,12 @@ void MainBus::write(Address addr, Byte value)
     }
     else
     {
+        // Bank switches and IRQ writes affect the PPU
+        m_syncCallback();
+        if (m_journalCallback)
+            m_journalCallback(addr, value);
         m_mapper->writePRG(addr, value);
+        updatePRGPages();
     }
 }
 
@@ -187,6 +211,21 @@ const Byte* MainBus::getPagePtr(Byte page)
     return nullptr;
 }
 
+void MainBus::setSyncCallback(std::function<void(void)> cb)
+{
+    m_syncCallback = cb;
+}
+
+void MainBus::setJournalCallback(std::function<void(Address, int)> cb)
+{
+    m_journalCallback = cb;
+}
+
+void MainBus::snapshot(Snapshot& state)
+{
+    state(m_readPages, m_writePages, m_RAM, m_extRAM, m_statusReads, m_registerReads);
+}
+
 bool MainBus::setMapper(Mapper* mapper)
 {
     m_mapper = mapper;
@@ -198,8 +237,24 @@ bool MainBus::setMapper(Mapper* mapper)
     }
 
     if (mapper->hasExtendedRAM())
+    {
         m_extRAM.resize(0x2000);
+        for (int page = 0x60; page < 0x80; ++page)
+        {
+            m_readPages[page] = m_writePages[page] = &m_extRAM[(page - 0x60) << 8];
+        }
+    }
+
+    updatePRGPages();
 
     return true;
 }
+
+void MainBus::updatePRGPages()
+{
+    for (int page = 0x80; page < 0x100; ++page)
+    {
+        m_readPages[page] = m_mapper->getPRGPagePtr(page << 8);
+    }
+}
 };
@@ -7,9 +7,78 @@
 #include "MapperNROM.h"
 #include "MapperSxROM.h"
 #include "MapperUxROM.h"
+#include "Log.h"
 
 namespace sn
 {
+void Mapper::writeCHR(Address addr, Byte value)
+{
+    Byte* window = m_chrWriteWindows[addr >> 10];
+    if (window)
+    {
+        window[addr & 0x3ff] = value;
+        // Both planes of a row decode together
+        const auto offset    = m_chrOffsets[addr >> 10] + (addr & 0x3ff);
+        m_patternRows[(offset >> 4 << 3) | (offset & 7)] = 0;
+        ++m_chrVersion;
+    }
+    else
+        LOG(Info) << "Read-only CHR memory write attempt at " << std::hex << addr << std::endl;
+}
+
+void Mapper::snapshot(Snapshot& state)
+{
+    state(m_prgWindows, m_prgOffsets, m_chrWindows, m_chrOffsets, m_chrWriteWindows, m_characterRAM, m_chrVersion);
+    // Rows decoded from CHR-ROM never go stale, those from CHR-RAM do when it is restored
+    if (!m_characterRAM.empty())
+        state(m_patternRows);
+}
+
+void Mapper::mapPRG(Address addr, std::size_t size, std::size_t offset)
+{
+    const auto& rom = m_cartridge.getROM();
+    for (std::size_t i = 0; i < size; i += 0x2000)
+    {
+        auto window          = ((addr + i) >> 13) & 0x3;
+        m_prgOffsets[window] = (offset + i) % rom.size();
+        m_prgWindows[window] = &rom[m_prgOffsets[window]];
+    }
+}
+
+void Mapper::mapCHR(Address addr, std::size_t size, std::size_t offset)
+{
+    const auto chrSize = m_characterRAM.empty() ? m_cartridge.getVROM().size() : m_characterRAM.size();
+    if (m_patternRows.size() != chrSize / 2)
+        m_patternRows.assign(chrSize / 2, 0);
+    ++m_chrVersion;
+
+    for (std::size_t i = 0; i < size; i += 0x400)
+    {
+        auto window          = (addr + i) >> 10;
+        m_chrOffsets[window] = (offset + i) % chrSize;
+        if (!m_characterRAM.empty())
+        {
+            m_chrWriteWindows[window] = &m_characterRAM[m_chrOffsets[window]];
+            m_chrWindows[window]      = m_chrWriteWindows[window];
+        }
+        else
+        {
+            m_chrWindows[window]      = &m_cartridge.getVROM()[m_chrOffsets[window]];
+            m_chrWriteWindows[window] = nullptr;
+        }
+    }
+}
+
+std::uint32_t Mapper::decodePatternRow(Address addr)
+{
+    const Byte    low = readCHR(addr), high = readCHR(addr + 8);
+    // Marks the row as decoded, even if all its pixels are 0
+    std::uint32_t row = 0x10000;
+    for (int x = 0; x < 8; ++x)
+        row |= (((low >> (7 - x)) & 1) | ((high >> (7 - x)) & 1) << 1) << (2 * x);
+    return row;
+}
+
 NameTableMirroring Mapper::getNameTableMirroring()
 {
     return static_cast<NameTableMirroring>(m_cartridge.getNameTableMirroring());
@@ -7,7 +7,6 @@ MapperAxROM::MapperAxROM(Cartridge& cart, std::function<void(void)> mirroring_cb
   : Mapper(cart, Mapper::AxROM)
   , m_mirroring(OneScreenLower)
   , m_mirroringCallback(mirroring_cb)
-  , m_prgBank(0)
 {
     if (cart.getROM().size() >= 0x8000)
     {
@@ -18,24 +17,16 @@ MapperAxROM::MapperAxROM(Cartridge& cart, std::function<void(void)> mirroring_cb
         m_characterRAM.resize(0x2000);
         LOG(Info) << "Uses Character RAM OK" << std::endl;
     }
-}
-
-Byte MapperAxROM::readPRG(Address address)
-{
-    if (address >= 0x8000)
-    {
-
-        return m_cartridge.getROM()[m_prgBank * 0x8000 + (address & 0x7FFF)];
-    }
 
-    return 0;
+    mapPRG(0x8000, 0x8000, 0);
+    mapCHR(0, 0x2000, 0);
 }
 
 void MapperAxROM::writePRG(Address address, Byte value)
 {
     if (address >= 0x8000)
     {
-        m_prgBank   = value & 0x07;
+        mapPRG(0x8000, 0x8000, (value & 0x07) * 0x8000);
         m_mirroring = (value & 0x10) ? OneScreenHigher : OneScreenLower;
         m_mirroringCallback();
     }
@@ -46,22 +37,10 @@ NameTableMirroring MapperAxROM::getNameTableMirroring()
     return m_mirroring;
 }
 
-Byte MapperAxROM::readCHR(Address address)
+void MapperAxROM::snapshot(Snapshot& state)
 {
-    if (address < 0x2000)
-    {
-        return m_characterRAM[address];
-    }
-
-    return 0;
-}
-
-void MapperAxROM::writeCHR(Address address, Byte value)
-{
-    if (address < 0x2000)
-    {
-        m_characterRAM[address] = value;
-    }
+    Mapper::snapshot(state);
+    state(m_mirroring);
 }
 
 }
@@ -9,34 +9,17 @@ MapperColorDreams::MapperColorDreams(Cartridge& cart, std::function<void(void)>
   , m_mirroring(Vertical)
   , m_mirroringCallback(mirroring_cb)
 {
-}
-
-Byte MapperColorDreams::readPRG(Address address)
-{
-    if (address >= 0x8000)
-    {
-        return m_cartridge.getROM()[(prgbank * 0x8000) + (address & 0x7fff)];
-    }
-    return 0;
+    mapPRG(0x8000, 0x8000, 0);
+    mapCHR(0, 0x2000, 0);
 }
 
 void MapperColorDreams::writePRG(Address address, Byte value)
 {
     if (address >= 0x8000)
     {
-        prgbank = ((value >> 0) & 0x3);
-        chrbank = ((value >> 4) & 0xF);
-    }
-}
-
-Byte MapperColorDreams::readCHR(Address address)
-{
-    if (address <= 0x1FFF)
-    {
-        return m_cartridge.getVROM()[(chrbank * 0x2000) + address];
+        mapPRG(0x8000, 0x8000, ((value >> 0) & 0x3) * 0x8000);
+        mapCHR(0, 0x2000, ((value >> 4) & 0xF) * 0x2000);
     }
-
-    return 0;
 }
 
 NameTableMirroring MapperColorDreams::getNameTableMirroring()
@@ -44,5 +27,9 @@ NameTableMirroring MapperColorDreams::getNameTableMirroring()
     return m_mirroring;
 }
 
-void MapperColorDreams::writeCHR(Address, Byte) {}
+void MapperColorDreams::snapshot(Snapshot& state)
+{
+    Mapper::snapshot(state);
+    state(m_mirroring);
+}
 }
@@ -8,45 +8,29 @@ MapperGxROM::MapperGxROM(Cartridge& cart, std::function<void(void)> mirroring_cb
   , m_mirroring(Vertical)
   , m_mirroringCallback(mirroring_cb)
 {
-}
-
-Byte MapperGxROM::readPRG(Address address)
-{
-    if (address >= 0x8000)
-    {
-        return m_cartridge.getROM()[(prgbank * 0x8000) + (address & 0x7fff)];
-    }
-
-    return 0;
+    mapPRG(0x8000, 0x8000, 0);
+    mapCHR(0, 0x2000, 0);
 }
 
 void MapperGxROM::writePRG(Address address, Byte value)
 {
     if (address >= 0x8000)
     {
-        prgbank     = ((value & 0x30) >> 4);
-        chrbank     = (value & 0x3);
+        mapPRG(0x8000, 0x8000, ((value & 0x30) >> 4) * 0x8000);
+        mapCHR(0, 0x2000, (value & 0x3) * 0x2000);
         m_mirroring = Vertical;
     }
     m_mirroringCallback();
 }
 
-Byte MapperGxROM::readCHR(Address address)
-{
-    if (address <= 0x1FFF)
-    {
-        return m_cartridge.getVROM()[chrbank * 0x2000 + address];
-    }
-    return 0;
-}
-
 NameTableMirroring MapperGxROM::getNameTableMirroring()
 {
     return m_mirroring;
 }
 
-void MapperGxROM::writeCHR(Address, Byte)
+void MapperGxROM::snapshot(Snapshot& state)
 {
-    LOG(Info) << "not expecting writes here";
+    Mapper::snapshot(state);
+    state(m_mirroring);
 }
 }
@@ -13,83 +13,41 @@ MapperMMC3::MapperMMC3(Cartridge& cart, IRQHandle& irq, std::function<void(void)
   , m_irqCounter(0)
   , m_irqLatch(0)
   , m_irqReloadPending(false)
-  , m_prgRam(32 * 1024)
   , m_mirroringRam(4 * 1024)
   , m_mirroring(Horizontal)
   , m_mirroringCallback(mirroring_cb)
   , m_irq(irq)
 {
-    m_prgBank0 = &cart.getROM()[cart.getROM().size() - 0x4000];
-    m_prgBank1 = &cart.getROM()[cart.getROM().size() - 0x2000];
-    m_prgBank2 = &cart.getROM()[cart.getROM().size() - 0x4000];
-    m_prgBank3 = &cart.getROM()[cart.getROM().size() - 0x2000];
+    mapPRG(0x8000, 0x4000, cart.getROM().size() - 0x4000);
+    mapPRG(0xc000, 0x4000, cart.getROM().size() - 0x4000);
 
-    for (auto& bank : m_chrBanks)
+    if (cart.getVROM().size() == 0)
     {
-        bank = cart.getVROM().size() - 0x400;
+        m_characterRAM.resize(0x2000);
+        LOG(Info) << "Uses character RAM" << std::endl;
     }
-    m_chrBanks[0] = cart.getVROM().size() - 0x800;
-    m_chrBanks[3] = cart.getVROM().size() - 0x800;
-}
 
-Byte MapperMMC3::readPRG(Address addr)
-{
-    if (addr >= 0x6000 && addr <= 0x7FFF)
-    {
-        return m_prgRam[addr & 0x1fff];
-    }
-
-    if (addr >= 0x8000 && addr <= 0x9FFF)
-    {
-        return *(m_prgBank0 + (addr & 0x1fff));
-    }
-
-    if (addr >= 0xA000 && addr <= 0xBFFF)
-    {
-        return *(m_prgBank1 + (addr & 0x1fff));
-    }
-
-    if (addr >= 0xC000 && addr <= 0xDFFF)
-    {
-        return *(m_prgBank2 + (addr & 0x1fff));
-    }
-
-    if (addr >= 0xE000)
+    const auto chrSize = cart.getVROM().size() ? cart.getVROM().size() : m_characterRAM.size();
+    for (auto& bank : m_chrBanks)
     {
-        return *(m_prgBank3 + (addr & 0x1fff));
+        bank = chrSize - 0x400;
     }
-
-    return 0;
+    m_chrBanks[0] = chrSize - 0x800;
+    m_chrBanks[3] = chrSize - 0x800;
+    mapCHRBanks();
 }
 
-Byte MapperMMC3::readCHR(Address addr)
+void MapperMMC3::mapCHRBanks()
 {
-    if (addr < 0x1fff)
-    {
-        // select 1kb bank
-        const auto bankSelect  = addr >> 10;
-        // get the configured base address for the bank
-        const auto baseAddress = m_chrBanks[bankSelect];
-        const auto offset      = addr & 0x3ff;
-        return m_cartridge.getVROM()[baseAddress + offset];
-    }
-    else if (addr <= 0x2fff)
+    for (std::size_t i = 0; i < m_chrBanks.size(); ++i)
     {
-        return m_mirroringRam[addr - 0x2000];
+        mapCHR(i * 0x400, 0x400, m_chrBanks[i]);
     }
-
-    return 0;
 }
 
 void MapperMMC3::writePRG(Address addr, Byte value)
 {
-
-    if (addr >= 0x6000 && addr <= 0x7FFF)
-    {
-        m_prgRam[addr & 0x1FFF] = value;
-    }
-
-    else if (addr >= 0x8000 && addr <= 0x9FFF)
+    if (addr >= 0x8000 && addr <= 0x9FFF)
     {
         // Bank Select
         if (!(addr & 0x01))
@@ -125,21 +83,21 @@ void MapperMMC3::writePRG(Address addr, Byte value)
                 m_chrBanks[6] = (m_bankRegister[1] & 0xFE) * 0x0400;
                 m_chrBanks[7] = (m_bankRegister[1] & 0xFE) * 0x0400 + 0x0400;
             }
+            mapCHRBanks();
 
             if (m_prgBankMode == 0)
             {
                 // ignore top two bits for R6 / R7 using 0x3F
-                m_prgBank0 = &m_cartridge.getROM()[(m_bankRegister[6] & 0x3F) * 0x2000];
-                m_prgBank1 = &m_cartridge.getROM()[(m_bankRegister[7] & 0x3F) * 0x2000];
-                m_prgBank2 = &m_cartridge.getROM()[m_cartridge.getROM().size() - 0x4000];
-                m_prgBank3 = &m_cartridge.getROM()[m_cartridge.getROM().size() - 0x2000];
+                mapPRG(0x8000, 0x2000, (m_bankRegister[6] & 0x3F) * 0x2000);
+                mapPRG(0xa000, 0x2000, (m_bankRegister[7] & 0x3F) * 0x2000);
+                mapPRG(0xc000, 0x4000, m_cartridge.getROM().size() - 0x4000);
             }
             else if (m_prgBankMode == 1)
             {
-                m_prgBank0 = &m_cartridge.getROM()[m_cartridge.getROM().size() - 0x4000];
-                m_prgBank1 = &m_cartridge.getROM()[(m_bankRegister[7] & 0x3F) * 0x2000];
-                m_prgBank2 = &m_cartridge.getROM()[(m_bankRegister[6] & 0x3F) * 0x2000];
-                m_prgBank3 = &m_cartridge.getROM()[m_cartridge.getROM().size() - 0x2000];
+                mapPRG(0x8000, 0x2000, m_cartridge.getROM().size() - 0x4000);
+                mapPRG(0xa000, 0x2000, (m_bankRegister[7] & 0x3F) * 0x2000);
+                mapPRG(0xc000, 0x2000, (m_bankRegister[6] & 0x3F) * 0x2000);
+                mapPRG(0xe000, 0x2000, m_cartridge.getROM().size() - 0x2000);
             }
         }
     }
@@ -189,14 +147,6 @@ void MapperMMC3::writePRG(Address addr, Byte value)
     }
 }
 
-void MapperMMC3::writeCHR(Address addr, Byte value)
-{
-    if (addr >= 0x2000 && addr <= 0x2fff)
-    {
-        m_mirroringRam[addr - 0x2000] = value;
-    }
-}
-
 void MapperMMC3::scanlineIRQ()
 {
     bool zeroTransition = false;
@@ -224,4 +174,11 @@ NameTableMirroring MapperMMC3::getNameTableMirroring()
     return m_mirroring;
 }
 
+void MapperMMC3::snapshot(Snapshot& state)
+{
+    Mapper::snapshot(state);
+    state(m_targetRegister, m_prgBankMode, m_chrInversion, m_bankRegister, m_chrBanks, m_mirroring);
+    state(m_irqEnabled, m_irqCounter, m_irqLatch, m_irqReloadPending, m_mirroringRam);
+}
+
 } // namespace sn
@@ -14,35 +14,24 @@ MapperSxROM::MapperSxROM(Cartridge& cart, std::function<void(void)> mirroring_cb
   , m_regPRG(0)
   , m_regCHR0(0)
   , m_regCHR1(0)
-  , m_firstBankPRG(nullptr)
-  , m_secondBankPRG(nullptr)
   , m_firstBankCHRIdx(0)
   , m_secondBankCHRIdx(0)
 {
     if (cart.getVROM().size() == 0)
     {
-        m_usesCharacterRAM = true;
         m_characterRAM.resize(0x8000);
         LOG(Info) << "Uses character RAM" << std::endl;
     }
     else
     {
         LOG(Info) << "Using CHR-ROM" << std::endl;
-        m_usesCharacterRAM = false;
         m_firstBankCHRIdx  = 0;
         m_secondBankCHRIdx = 0x1000 * m_regCHR1;
     }
 
-    m_firstBankPRG  = &cart.getROM()[0];                                               // first bank
-    m_secondBankPRG = &cart.getROM()[cart.getROM().size() - 0x4000 /*0x2000 * 0x0e*/]; // last bank
-}
-
-Byte MapperSxROM::readPRG(Address addr)
-{
-    if (addr < 0xc000)
-        return *(m_firstBankPRG + (addr & 0x3fff));
-    else
-        return *(m_secondBankPRG + (addr & 0x3fff));
+    mapPRG(0x8000, 0x4000, 0);                                               // first bank
+    mapPRG(0xc000, 0x4000, cart.getROM().size() - 0x4000 /*0x2000 * 0x0e*/); // last bank
+    calculateCHRPointers();
 }
 
 NameTableMirroring MapperSxROM::getNameTableMirroring()
@@ -120,6 +109,7 @@ void MapperSxROM::writePRG(Address addr, Byte value)
                 m_regPRG        = m_tempRegister;
                 calculatePRGPointers();
             }
+            calculateCHRPointers();
 
             m_tempRegister = 0;
             m_writeCounter = 0;
@@ -139,51 +129,30 @@ void MapperSxROM::calculatePRGPointers()
     if (m_modePRG <= 1) // 32KB changeable
     {
         // equivalent to multiplying 0x8000 * (m_regPRG >> 1)
-        m_firstBankPRG  = &m_cartridge.getROM()[0x4000 * (m_regPRG & ~1)];
-        m_secondBankPRG = m_firstBankPRG + 0x4000; // add 16KB
+        mapPRG(0x8000, 0x8000, 0x4000 * (m_regPRG & ~1));
     }
     else if (m_modePRG == 2) // fix first switch second
     {
-        m_firstBankPRG  = &m_cartridge.getROM()[0];
-        m_secondBankPRG = m_firstBankPRG + 0x4000 * m_regPRG;
+        mapPRG(0x8000, 0x4000, 0);
+        mapPRG(0xc000, 0x4000, 0x4000 * m_regPRG);
     }
     else // switch first fix second
     {
-        m_firstBankPRG  = &m_cartridge.getROM()[0x4000 * m_regPRG];
-        m_secondBankPRG = &m_cartridge.getROM()[m_cartridge.getROM().size() - 0x4000 /*0x2000 * 0x0e*/];
+        mapPRG(0x8000, 0x4000, 0x4000 * m_regPRG);
+        mapPRG(0xc000, 0x4000, m_cartridge.getROM().size() - 0x4000 /*0x2000 * 0x0e*/);
     }
 }
 
-Byte MapperSxROM::readCHR(Address addr)
+void MapperSxROM::calculateCHRPointers()
 {
-    if (m_usesCharacterRAM)
-    {
-        if (addr < 0x1000)
-            return m_characterRAM[m_firstBankCHRIdx + addr];
-        else
-            return m_characterRAM[m_secondBankCHRIdx + (addr & 0xfff)];
-    }
-    else
-    {
-        if (addr < 0x1000)
-            return m_cartridge.getVROM()[m_firstBankCHRIdx + addr];
-        else
-            return m_cartridge.getVROM()[m_secondBankCHRIdx + (addr & 0xfff)];
-    }
+    mapCHR(0, 0x1000, m_firstBankCHRIdx);
+    mapCHR(0x1000, 0x1000, m_secondBankCHRIdx);
 }
 
-void MapperSxROM::writeCHR(Address addr, Byte value)
+void MapperSxROM::snapshot(Snapshot& state)
 {
-    if (m_usesCharacterRAM)
-    {
-        if (addr < 0x1000)
-            m_characterRAM[m_firstBankCHRIdx + addr] = value;
-        else
-            m_characterRAM[m_secondBankCHRIdx + (addr & 0xfff)] = value;
-    }
-    else
-    {
-        LOG(Info) << "Read-only CHR memory write attempt at " << std::hex << addr << std::endl;
-    }
+    Mapper::snapshot(state);
+    state(m_mirroing, m_modeCHR, m_modePRG, m_tempRegister, m_writeCounter, m_regPRG, m_regCHR0, m_regCHR1);
+    state(m_firstBankCHRIdx, m_secondBankCHRIdx);
 }
 }
@@ -1,5 +1,7 @@
 #include "PPU.h"
 #include "Log.h"
+#include <algorithm>
+#include <limits>
 
 namespace sn
 {
@@ -7,19 +9,30 @@ PPU::PPU(PictureBus& bus, VirtualScreen& screen)
   : m_bus(bus)
   , m_screen(screen)
   , m_spriteMemory(64 * 4)
-  , m_pictureBuffer(ScanlineVisibleDots, std::vector<sf::Color>(VisibleScanlines, sf::Color::Magenta))
+  , m_frameSkip(0)
+  , m_skippedFrames(0)
+  , m_frame(ScanlineVisibleDots * VisibleScanlines)
+  , m_lineMasks(VisibleScanlines)
 {
 }
 
 void PPU::reset()
 {
     m_longSprites = m_generateInterrupt = m_greyscaleMode = m_vblank = m_spriteOverflow = false;
+    m_emphasis        = 0;
+    m_bgTileFetched   = false;
+    m_spriteLineReady = false;
+    m_spriteLineCHR   = 0;
+    m_skipFrame       = false;
+    m_skippedFrames   = 0;
+    m_frameCount      = 0;
     m_showBackground = m_showSprites = m_evenFrame = m_firstWrite = true;
     m_bgPage = m_sprPage = Low;
     m_dataAddress = m_cycle = m_scanline = m_spriteDataAddress = m_fineXScroll = m_tempAddress = 0;
     // m_baseNameTable = 0x2000;
     m_dataAddrIncrement                                                                        = 1;
     m_pipelineState                                                                            = PreRender;
+    m_lastStatus                                                                               = 0;
     m_scanlineSprites.reserve(8);
     m_scanlineSprites.resize(0);
 }
@@ -29,6 +42,11 @@ void PPU::setInterruptCallback(std::function<void(void)> cb)
     m_vblankCallback = cb;
 }
 
+void PPU::setFrameSkip(int frames)
+{
+    m_frameSkip = frames;
+}
+
 void PPU::step()
 {
     switch (m_pipelineState)
@@ -55,6 +73,13 @@ void PPU::step()
         {
             m_pipelineState = Render;
             m_cycle = m_scanline = 0;
+            // Sprites aren't evaluated for the first line, those found at the end of the last one never show
+            m_scanlineSprites.resize(0);
+            m_spriteLineReady = false;
+
+            // A frame is either drawn or skipped as a whole
+            m_skipFrame       = m_frameSkip < 0 || m_skippedFrames < m_frameSkip;
+            m_skippedFrames   = m_skipFrame ? m_skippedFrames + 1 : 0;
         }
 
         // add IRQ support for MMC3
@@ -66,126 +91,8 @@ void PPU::step()
     case Render:
         if (m_cycle > 0 && m_cycle <= ScanlineVisibleDots)
         {
-            Byte bgColor = 0, sprColor = 0;
-            bool bgOpaque = false, sprOpaque = true;
-            bool spriteForeground = false;
-
-            int  x                = m_cycle - 1;
-            int  y                = m_scanline;
-
-            if (m_showBackground)
-            {
-                auto x_fine = (m_fineXScroll + x) % 8;
-                if (!m_hideEdgeBackground || x >= 8)
-                {
-                    // fetch tile
-                    auto addr  = 0x2000 | (m_dataAddress & 0x0FFF); // mask off fine y
-                    // auto addr = 0x2000 + x / 8 + (y / 8) * (ScanlineVisibleDots / 8);
-                    Byte tile  = read(addr);
-
-                    // fetch pattern
-                    // Each pattern occupies 16 bytes, so multiply by 16
-                    addr       = (tile * 16) + ((m_dataAddress >> 12 /*y % 8*/) & 0x7); // Add fine y
-                    addr      |= m_bgPage << 12; // set whether the pattern is in the high or low page
-                    // Get the corresponding bit determined by (8 - x_fine) from the right
-                    bgColor    = (read(addr) >> (7 ^ x_fine)) & 1;            // bit 0 of palette entry
-                    bgColor   |= ((read(addr + 8) >> (7 ^ x_fine)) & 1) << 1; // bit 1
-
-                    bgOpaque   = bgColor; // flag used to calculate final pixel with the sprite pixel
-
-                    // fetch attribute and calculate higher two bits of palette
-                    addr =
-                      0x23C0 | (m_dataAddress & 0x0C00) | ((m_dataAddress >> 4) & 0x38) | ((m_dataAddress >> 2) & 0x07);
-                    auto attribute  = read(addr);
-                    int  shift      = ((m_dataAddress >> 4) & 4) | (m_dataAddress & 2);
-                    // Extract and set the upper two bits for the color
-                    bgColor        |= ((attribute >> shift) & 0x3) << 2;
-                }
-                // Increment/wrap coarse X
-                if (x_fine == 7)
-                {
-                    if ((m_dataAddress & 0x001F) == 31) // if coarse X == 31
-                    {
-                        m_dataAddress &= ~0x001F; // coarse X = 0
-                        m_dataAddress ^= 0x0400;  // switch horizontal nametable
-                    }
-                    else
-                    {
-                        m_dataAddress += 1; // increment coarse X
-                    }
-                }
-            }
-
-            if (m_showSprites && (!m_hideEdgeSprites || x >= 8))
-            {
-                for (auto i : m_scanlineSprites)
-                {
-                    Byte spr_x = m_spriteMemory[i * 4 + 3];
-
-                    if (0 > x - spr_x || x - spr_x >= 8)
-                        continue;
-
-                    Byte spr_y = m_spriteMemory[i * 4 + 0] + 1, tile = m_spriteMemory[i * 4 + 1],
-                         attribute = m_spriteMemory[i * 4 + 2];
-
-                    int length     = (m_longSprites) ? 16 : 8;
-
-                    int x_shift = (x - spr_x) % 8, y_offset = (y - spr_y) % length;
-
-                    if ((attribute & 0x40) == 0) // If NOT flipping horizontally
-                        x_shift ^= 7;
-                    if ((attribute & 0x80) != 0) // IF flipping vertically
-                        y_offset ^= (length - 1);
-
-                    Address addr = 0;
-
-                    if (!m_longSprites)
-                    {
-                        addr = tile * 16 + y_offset;
-                        if (m_sprPage == High)
-                            addr += 0x1000;
-                    }
-                    else // 8x16 sprites
-                    {
-                        // bit-3 is one if it is the bottom tile of the sprite, multiply by two to get the next pattern
-                        y_offset  = (y_offset & 7) | ((y_offset & 8) << 1);
-                        addr      = (tile >> 1) * 32 + y_offset;
-                        addr     |= (tile & 1) << 12; // Bank 0x1000 if bit-0 is high
-                    }
-
-                    sprColor |= (read(addr) >> (x_shift)) & 1;            // bit 0 of palette entry
-                    sprColor |= ((read(addr + 8) >> (x_shift)) & 1) << 1; // bit 1
-
-                    if (!(sprOpaque = sprColor))
-                    {
-                        sprColor = 0;
-                        continue;
-                    }
-
-                    sprColor         |= 0x10;                   // Select sprite palette
-                    sprColor         |= (attribute & 0x3) << 2; // bits 2-3
-
-                    spriteForeground  = !(attribute & 0x20);
-
-                    // Sprite-0 hit detection
-                    if (!m_sprZeroHit && m_showBackground && i == 0 && sprOpaque && bgOpaque)
-                    {
-                        m_sprZeroHit = true;
-                    }
-
-                    break; // Exit the loop now since we've found the highest priority sprite
-                }
-            }
-
-            Byte paletteAddr = bgColor;
-
-            if ((!bgOpaque && sprOpaque) || (bgOpaque && sprOpaque && spriteForeground))
-                paletteAddr = sprColor;
-            else if (!bgOpaque && !sprOpaque)
-                paletteAddr = 0;
-            // else bgColor
-
-            m_pictureBuffer[x][y] = sf::Color(colors[m_bus.readPalette(paletteAddr)]);
+            int x = m_cycle - 1;
+            drawPixel(x, m_showBackground ? backgroundPixel(x) : 0);
         }
         else if (m_cycle == ScanlineVisibleDots + 1 && m_showBackground)
         {
@@ -256,7 +163,13 @@ void PPU::step()
             }
 
             ++m_scanline;
-            m_cycle = 0;
+            m_cycle           = 0;
+            m_spriteLineReady = false;
+            // A skipped frame only needs the sprites for sprite 0 hits
+            if (m_scanline < VisibleScanlines &&
+                (!m_skipFrame || std::find(m_scanlineSprites.begin(), m_scanlineSprites.end(), 0) !=
+                                   m_scanlineSprites.end()))
+                prepareSpriteLine();
         }
 
         if (m_scanline >= VisibleScanlines)
@@ -269,14 +182,10 @@ void PPU::step()
             ++m_scanline;
             m_cycle         = 0;
             m_pipelineState = VerticalBlank;
+            ++m_frameCount;
 
-            for (std::size_t x = 0; x < m_pictureBuffer.size(); ++x)
-            {
-                for (std::size_t y = 0; y < m_pictureBuffer[0].size(); ++y)
-                {
-                    m_screen.setPixel(x, y, m_pictureBuffer[x][y]);
-                }
-            }
+            if (!m_skipFrame)
+                m_screen.setFrame(m_frame.data(), m_lineMasks.data());
         }
 
         break;
@@ -309,6 +218,294 @@ void PPU::step()
     ++m_cycle;
 }
 
+void PPU::step(int steps)
+{
+    // Registers, nametables or CHR banks may have changed since the last steps. The sprites of the line were picked
+    // and drawn at the evaluation, as on hardware later OAM writes don't reach them, but the pattern tables do
+    m_bgTileFetched = false;
+    if (m_spriteLineCHR != m_bus.getCHRVersion())
+        m_spriteLineReady = false;
+
+    while (steps > 0)
+    {
+        // Nothing can observe the PPU before the steps are done, so a visible line that fits is drawn in one go
+        if (m_pipelineState == Render && m_cycle == 1 && steps >= ScanlineVisibleDots)
+        {
+            renderScanline();
+            m_cycle += ScanlineVisibleDots;
+            steps   -= ScanlineVisibleDots;
+        }
+        else if (int idle = std::min(idleDots(), steps))
+        {
+            m_cycle += idle;
+            steps   -= idle;
+        }
+        else
+        {
+            step();
+            --steps;
+        }
+    }
+}
+
+int PPU::idleDots() const
+{
+    int next = m_cycle;
+    switch (m_pipelineState)
+    {
+    case PreRender:
+        // The odd frame's line may end one dot early
+        if (m_cycle > 304)
+            next = ScanlineEndCycle - 1;
+        break;
+    case Render:
+        if (m_cycle > 260)
+            next = ScanlineEndCycle;
+        break;
+    case PostRender:
+        next = ScanlineEndCycle;
+        break;
+    case VerticalBlank:
+        if (m_cycle > 1)
+            next = ScanlineEndCycle;
+        break;
+    }
+    return std::max(next - m_cycle, 0);
+}
+
+void PPU::renderScanline()
+{
+    // Without pixels to draw, the background only moves on by the 32 tiles of the line
+    if (m_skipFrame && !canHitSpriteZero())
+    {
+        if (m_showBackground)
+        {
+            for (int tile = 0; tile < ScanlineVisibleDots / 8; ++tile)
+                incrementCoarseX();
+        }
+        m_bgTileFetched = false;
+        return;
+    }
+
+    for (int x = 0; x < ScanlineVisibleDots; ++x)
+        drawPixel(x, m_showBackground ? backgroundPixel(x) : 0);
+}
+
+bool PPU::canHitSpriteZero() const
+{
+    return !m_sprZeroHit && m_showBackground && m_showSprites &&
+           std::find(m_scanlineSprites.begin(), m_scanlineSprites.end(), 0) != m_scanlineSprites.end();
+}
+
+Byte PPU::backgroundPixel(int x)
+{
+    auto x_fine = (m_fineXScroll + x) % 8;
+    // A tile is fetched once, when the address first points to it, then shifted out a pixel per dot
+    if (x == 0 || !m_bgTileFetched)
+    {
+        fetchTile();
+        m_bgPatternShift >>= 2 * x_fine;
+    }
+
+    Byte color         = (m_bgPatternShift & 3) | m_bgAttributeLatch;
+    m_bgPatternShift >>= 2;
+
+    // Increment/wrap coarse X
+    if (x_fine == 7)
+    {
+        incrementCoarseX();
+        m_bgTileFetched = false;
+    }
+
+    if (m_hideEdgeBackground && x < 8)
+        return 0;
+    return color;
+}
+
+void PPU::fetchTile()
+{
+    // fetch tile
+    auto addr  = 0x2000 | (m_dataAddress & 0x0FFF); // mask off fine y
+    Byte tile  = read(addr);
+
+    // fetch pattern
+    // Each pattern occupies 16 bytes, so multiply by 16
+    addr              = (tile * 16) + ((m_dataAddress >> 12 /*y % 8*/) & 0x7); // Add fine y
+    addr             |= m_bgPage << 12; // set whether the pattern is in the high or low page
+    m_bgPatternShift  = m_bus.readPatternRow(addr);
+
+    // fetch attribute and calculate higher two bits of palette
+    addr = 0x23C0 | (m_dataAddress & 0x0C00) | ((m_dataAddress >> 4) & 0x38) | ((m_dataAddress >> 2) & 0x07);
+    auto attribute     = read(addr);
+    int  shift         = ((m_dataAddress >> 4) & 4) | (m_dataAddress & 2);
+    m_bgAttributeLatch = ((attribute >> shift) & 0x3) << 2;
+    m_bgTileFetched    = true;
+}
+
+void PPU::incrementCoarseX()
+{
+    if ((m_dataAddress & 0x001F) == 31) // if coarse X == 31
+    {
+        m_dataAddress &= ~0x001F; // coarse X = 0
+        m_dataAddress ^= 0x0400;  // switch horizontal nametable
+    }
+    else
+    {
+        m_dataAddress += 1; // increment coarse X
+    }
+}
+
+void PPU::prepareSpriteLine()
+{
+    m_spriteLine.fill(0);
+
+    int y = m_scanline;
+    for (auto i : m_scanlineSprites)
+    {
+        Byte spr_x = m_spriteMemory[i * 4 + 3];
+        Byte tile = m_spriteMemory[i * 4 + 1], attribute = m_spriteMemory[i * 4 + 2];
+
+        int  length   = (m_longSprites) ? 16 : 8;
+
+        // Sprites are drawn a line below their Y. OAM may have been written since the evaluation, a sprite that
+        // no longer covers the line isn't drawn
+        int  y_offset = y - 1 - m_spriteMemory[i * 4 + 0];
+        if (y_offset < 0 || y_offset >= length)
+            continue;
+
+        if ((attribute & 0x80) != 0) // IF flipping vertically
+            y_offset ^= (length - 1);
+
+        Address addr = 0;
+
+        if (!m_longSprites)
+        {
+            addr = tile * 16 + y_offset;
+            if (m_sprPage == High)
+                addr += 0x1000;
+        }
+        else // 8x16 sprites
+        {
+            // bit-3 is one if it is the bottom tile of the sprite, multiply by two to get the next pattern
+            y_offset  = (y_offset & 7) | ((y_offset & 8) << 1);
+            addr      = (tile >> 1) * 32 + y_offset;
+            addr     |= (tile & 1) << 12; // Bank 0x1000 if bit-0 is high
+        }
+
+        const auto row = m_bus.readPatternRow(addr);
+        for (int column = 0; column < 8 && spr_x + column < ScanlineVisibleDots; ++column)
+        {
+            // If flipping horizontally, the row is read from the right
+            Byte color = (row >> (2 * ((attribute & 0x40) ? column ^ 7 : column))) & 3; // bits 0-1 of palette entry
+
+            // Sprites earlier in the list have priority, transparent pixels let the next ones through
+            auto& pixel = m_spriteLine[spr_x + column];
+            if (pixel || !color)
+                continue;
+
+            pixel  = color | 0x10;                  // Select sprite palette
+            pixel |= (attribute & 0x3) << 2;        // bits 2-3
+            pixel |= attribute & SpriteBehind;
+            if (i == 0)
+                pixel |= SpriteZero;
+        }
+    }
+
+    m_spriteLineReady = true;
+    m_spriteLineCHR   = m_bus.getCHRVersion();
+}
+
+void PPU::drawPixel(int x, Byte bgColor)
+{
+    if (!m_spriteLineReady)
+        prepareSpriteLine();
+
+    // flag used to calculate final pixel with the sprite pixel
+    bool bgOpaque = bgColor & 3;
+    Byte sprite   = 0;
+    int  y        = m_scanline;
+
+    if (m_showSprites && (!m_hideEdgeSprites || x >= 8))
+        sprite = m_spriteLine[x];
+
+    // Sprite-0 hit detection
+    if (!m_sprZeroHit && m_showBackground && (sprite & SpriteZero) && bgOpaque)
+        m_sprZeroHit = true;
+
+    if (m_skipFrame)
+        return;
+
+    Byte paletteAddr = bgOpaque ? bgColor : 0;
+    if (sprite && (!bgOpaque || !(sprite & SpriteBehind)))
+        paletteAddr = sprite & 0x1f;
+
+    // Palette RAM only has 6 bits
+    m_frame[y * ScanlineVisibleDots + x] = m_bus.readPalette(paletteAddr) & 0x3f;
+    // A mask written mid-line applies to the whole line
+    m_lineMasks[y]                       = m_emphasis | m_greyscaleMode;
+}
+
+int PPU::stepsTo(int targetLine, int dot) const
+{
+    const int frameLines = FrameEndScanline + 1;
+    // The pre-render line comes before the visible ones
+    const int line       = m_pipelineState == PreRender ? -1 : m_scanline;
+
+    // Every line is at least one dot short of a full one, in case it is the odd frame's pre-render line
+    if (targetLine == line && dot >= m_cycle)
+        return dot - m_cycle + 1;
+    int linesBetween = (targetLine - line - 1 + frameLines) % frameLines;
+    return (ScanlineEndCycle - m_cycle) + linesBetween * (ScanlineEndCycle - 1) + dot;
+}
+
+int PPU::stepsUntilInterrupt() const
+{
+    const int line  = m_pipelineState == PreRender ? -1 : m_scanline;
+
+    int       steps = std::numeric_limits<int>::max();
+    if (m_generateInterrupt)
+        steps = stepsTo(VisibleScanlines + 1, 1);
+
+    if (m_showBackground && m_showSprites)
+    {
+        int irqLine = m_cycle <= 260 ? line : line + 1;
+        if (irqLine >= VisibleScanlines)
+            irqLine = -1;
+        steps = std::min(steps, stepsTo(irqLine, 260));
+    }
+
+    return steps;
+}
+
+int PPU::stepsUntilStatusChange() const
+{
+    // It may have changed since the program last read it
+    if ((m_spriteOverflow << 5 | m_sprZeroHit << 6 | m_vblank << 7) != m_lastStatus)
+        return 0;
+
+    const int line  = m_pipelineState == PreRender ? -1 : m_scanline;
+
+    // vblank is set, then cleared along with sprite 0 hit on the pre-render line
+    int       steps = std::min(stepsTo(VisibleScanlines + 1, 1), stepsTo(-1, 1));
+
+    // Overflow is found by the sprite evaluation at the end of a rendered line
+    if (!m_spriteOverflow && line < VisibleScanlines)
+        steps = std::min(steps, stepsTo(std::max(line, 0), ScanlineEndCycle));
+
+    // Sprite 0 can only hit on the lines following its Y position
+    const int range = m_longSprites ? 16 : 8;
+    const int spr0Y = m_spriteMemory[0];
+    if (!m_sprZeroHit && m_showBackground && m_showSprites && spr0Y + 1 < VisibleScanlines)
+    {
+        if (line <= spr0Y)
+            steps = std::min(steps, stepsTo(spr0Y + 1, 0));
+        else if (line <= spr0Y + range && line < VisibleScanlines)
+            steps = 1;
+    }
+
+    return steps;
+}
+
 Byte PPU::readOAM(Byte addr)
 {
     return m_spriteMemory[addr];
@@ -319,6 +516,24 @@ void PPU::writeOAM(Byte addr, Byte value)
     m_spriteMemory[addr] = value;
 }
 
+void PPU::snapshot(Snapshot& state)
+{
+    state(m_spriteMemory, m_scanlineSprites, m_spriteLine, m_spriteLineReady, m_spriteLineCHR);
+    state(m_pipelineState, m_cycle, m_scanline);
+    state(m_evenFrame, m_frameCount, m_skippedFrames, m_skipFrame, m_vblank, m_sprZeroHit, m_spriteOverflow);
+    state(m_lastStatus, m_dataAddress, m_tempAddress, m_fineXScroll, m_firstWrite, m_dataBuffer, m_spriteDataAddress);
+    state(m_bgPatternShift, m_bgAttributeLatch, m_bgTileFetched, m_longSprites, m_generateInterrupt);
+    state(m_greyscaleMode,
+          m_emphasis,
+          m_showSprites,
+          m_showBackground,
+          m_hideEdgeSprites,
+          m_hideEdgeBackground,
+          m_bgPage,
+          m_sprPage,
+          m_dataAddrIncrement);
+}
+
 void PPU::doDMA(const Byte* page_ptr)
 {
     std::memcpy(m_spriteMemory.data() + m_spriteDataAddress, page_ptr, 256 - m_spriteDataAddress);
@@ -328,6 +543,12 @@ void PPU::doDMA(const Byte* page_ptr)
 
 void PPU::control(Byte ctrl)
 {
+    // The sprites of the line follow their size and pattern table
+    const bool longSprites = ctrl & 0x20;
+    const auto sprPage     = static_cast<CharacterPage>(!!(ctrl & 0x8));
+    if (longSprites != m_longSprites || sprPage != m_sprPage)
+        m_spriteLineReady = false;
+
     m_generateInterrupt = ctrl & 0x80;
     m_longSprites       = ctrl & 0x20;
     m_bgPage            = static_cast<CharacterPage>(!!(ctrl & 0x10));
@@ -346,6 +567,7 @@ void PPU::control(Byte ctrl)
 void PPU::setMask(Byte mask)
 {
     m_greyscaleMode      = mask & 0x1;
+    m_emphasis           = mask & 0xe0;
     m_hideEdgeBackground = !(mask & 0x2);
     m_hideEdgeSprites    = !(mask & 0x4);
     m_showBackground     = mask & 0x8;
@@ -360,6 +582,7 @@ Byte PPU::getStatus()
     // Reading status clears vblank!
     m_vblank     = false;
     m_firstWrite = true;
+    m_lastStatus = status & ~0x80;
     return status;
 }
 
@@ -0,0 +1,168 @@
+#include "PPURenderer.h"
+#include "Log.h"
+#include "MainBus.h"
+
+namespace sn
+{
+PPURenderer::PPURenderer(VirtualScreen& screen)
+  : m_ppu(m_bus, screen)
+  , m_dot(0)
+  , m_stopping(false)
+{
+}
+
+PPURenderer::~PPURenderer()
+{
+    stop();
+}
+
+bool PPURenderer::start(Cartridge& cartridge, Mapper::Type type)
+{
+    stop();
+
+    m_mapper = Mapper::createMapper(type, cartridge, m_irq, [&]() { m_bus.updateMirroring(); });
+    if (!m_mapper || !m_bus.setMapper(m_mapper.get()))
+        return false;
+
+    m_ppu.reset();
+    m_ppu.setInterruptCallback([]() {});
+    m_dot      = 0;
+    m_journal  = Batch();
+    m_stopping = false;
+    m_thread   = std::thread(&PPURenderer::run, this);
+    return true;
+}
+
+void PPURenderer::stop()
+{
+    if (!isRunning())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        m_batches.clear();
+    }
+    m_condition.notify_all();
+    m_thread.join();
+}
+
+void PPURenderer::access(std::uint64_t dot, Address addr, int value)
+{
+    m_journal.entries.push_back({ dot, value < 0 ? Entry::Read : Entry::Write, addr, value });
+}
+
+void PPURenderer::dma(std::uint64_t dot, const Byte* page)
+{
+    m_journal.entries.push_back({ dot, Entry::DMA, 0, static_cast<int>(m_journal.dmaPages.size()) });
+    m_journal.dmaPages.insert(m_journal.dmaPages.end(), page, page + 0x100);
+}
+
+void PPURenderer::setFrameSkip(std::uint64_t dot, int frames)
+{
+    m_journal.entries.push_back({ dot, Entry::FrameSkip, 0, frames });
+}
+
+void PPURenderer::submit(std::uint64_t dot)
+{
+    m_journal.end = dot;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        // Rather than piling up batches, the emulation waits for a worker that can't keep up
+        m_condition.wait(lock, [&]() { return m_batches.size() < 2; });
+        m_batches.push_back(std::move(m_journal));
+    }
+    m_condition.notify_all();
+    m_journal = Batch();
+}
+
+void PPURenderer::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_condition.wait(lock, [&]() { return m_stopping || !m_batches.empty(); });
+        if (m_stopping)
+            return;
+
+        Batch batch = std::move(m_batches.front());
+        m_batches.pop_front();
+        lock.unlock();
+        m_condition.notify_all();
+
+        replay(batch);
+
+        lock.lock();
+    }
+}
+
+void PPURenderer::replay(const Batch& batch)
+{
+    for (const auto& entry : batch.entries)
+    {
+        stepTo(entry.dot);
+        switch (entry.type)
+        {
+        case Entry::Write:
+            write(entry.addr, entry.value);
+            break;
+        case Entry::Read:
+            // Both have side effects: the write toggle, and the read buffer and address
+            if (entry.addr == MainBus::PPU_STATUS)
+                m_ppu.getStatus();
+            else
+                m_ppu.getData();
+            break;
+        case Entry::DMA:
+            m_ppu.doDMA(&batch.dmaPages[entry.value]);
+            break;
+        case Entry::FrameSkip:
+            m_ppu.setFrameSkip(entry.value);
+            break;
+        }
+    }
+    stepTo(batch.end);
+}
+
+void PPURenderer::write(Address addr, Byte value)
+{
+    switch (addr)
+    {
+    case MainBus::PPU_CTRL:
+        m_ppu.control(value);
+        break;
+    case MainBus::PPU_MASK:
+        m_ppu.setMask(value);
+        break;
+    case MainBus::OAM_ADDR:
+        m_ppu.setOAMAddress(value);
+        break;
+    case MainBus::OAM_DATA:
+        m_ppu.setOAMData(value);
+        break;
+    case MainBus::PPU_ADDR:
+        m_ppu.setDataAddress(value);
+        break;
+    case MainBus::PPU_SCROL:
+        m_ppu.setScroll(value);
+        break;
+    case MainBus::PPU_DATA:
+        m_ppu.setData(value);
+        break;
+    default:
+        // Bank switches and mirroring
+        if (addr >= 0x8000)
+            m_mapper->writePRG(addr, value);
+        break;
+    }
+}
+
+void PPURenderer::stepTo(std::uint64_t dot)
+{
+    if (dot > m_dot)
+    {
+        m_ppu.step(static_cast<int>(dot - m_dot));
+        m_dot = dot;
+    }
+}
+}
@@ -4,8 +4,14 @@
 namespace sn
 {
 
+const std::array<Byte, 0x20> PictureBus::PaletteMirror = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+                                                           0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+                                                           0x00, 0x11, 0x12, 0x13, 0x04, 0x15, 0x16, 0x17,
+                                                           0x08, 0x19, 0x1a, 0x1b, 0x0c, 0x1d, 0x1e, 0x1f };
+
 PictureBus::PictureBus()
-  : m_palette(0x20)
+  : m_nameTables()
+  , m_palette(0x20)
   , m_RAM(0x800)
   , m_mapper(nullptr)
 {
@@ -13,7 +19,7 @@ PictureBus::PictureBus()
 
 Byte PictureBus::read(Address addr)
 {
-    // PictureBus is limited to 0x3fff
+    // PictureBus is limited to 0x3fff, higher addresses (v with fine Y set) mirror down into it
     addr = addr & 0x3fff;
 
     if (addr < 0x2000)
@@ -22,46 +28,16 @@ Byte PictureBus::read(Address addr)
     }
     else if (addr <= 0x3eff)
     {
-        const auto index          = addr & 0x3ff;
         // Name tables upto 0x3000, then mirrored upto 3eff
-        auto       normalizedAddr = addr;
-        if (addr >= 0x3000)
-        {
-            normalizedAddr -= 0x1000;
-        }
-
-        if (NameTable0 >= m_RAM.size())
-            return m_mapper->readCHR(normalizedAddr);
-        else if (normalizedAddr < 0x2400) // NT0
-            return m_RAM[NameTable0 + index];
-        else if (normalizedAddr < 0x2800) // NT1
-            return m_RAM[NameTable1 + index];
-        else if (normalizedAddr < 0x2c00) // NT2
-            return m_RAM[NameTable2 + index];
-        else /* if (normalizedAddr < 0x3000)*/ // NT3
-            return m_RAM[NameTable3 + index];
-    }
-    else if (addr <= 0x3fff)
-    {
-        auto paletteAddr = addr & 0x1f;
-        return readPalette(paletteAddr);
+        return m_nameTables[(addr >> 10) & 0x3][addr & 0x3ff];
     }
-    return 0;
-}
-
-Byte PictureBus::readPalette(Byte paletteAddr)
-{
-    // Addresses $3F10/$3F14/$3F18/$3F1C are mirrors of $3F00/$3F04/$3F08/$3F0C
-    if (paletteAddr >= 0x10 && paletteAddr % 4 == 0)
-    {
-        paletteAddr = paletteAddr & 0xf;
-    }
-    return m_palette[paletteAddr];
+    // Palette from 0x3f00, mirrored every 0x20 upto 0x3fff
+    return readPalette(addr & 0x1f);
 }
 
 void PictureBus::write(Address addr, Byte value)
 {
-    // PictureBus is limited to 0x3fff
+    // PictureBus is limited to 0x3fff, higher addresses (v with fine Y set) mirror down into it
     addr = addr & 0x3fff;
 
     if (addr < 0x2000)
@@ -70,65 +46,52 @@ void PictureBus::write(Address addr, Byte value)
     }
     else if (addr <= 0x3eff)
     {
-        const auto index          = addr & 0x3ff;
         // Name tables upto 0x3000, then mirrored upto 3eff
-        auto       normalizedAddr = addr;
-        if (addr >= 0x3000)
-        {
-            normalizedAddr -= 0x1000;
-        }
-
-        if (NameTable0 >= m_RAM.size())
-            m_mapper->writeCHR(normalizedAddr, value);
-        else if (normalizedAddr < 0x2400) // NT0
-            m_RAM[NameTable0 + index] = value;
-        else if (normalizedAddr < 0x2800) // NT1
-            m_RAM[NameTable1 + index] = value;
-        else if (normalizedAddr < 0x2c00) // NT2
-            m_RAM[NameTable2 + index] = value;
-        else // NT3
-            m_RAM[NameTable3 + index] = value;
+        m_nameTables[(addr >> 10) & 0x3][addr & 0x3ff] = value;
     }
-    else if (addr <= 0x3fff)
+    else
     {
-        auto palette = addr & 0x1f;
-        // Addresses $3F10/$3F14/$3F18/$3F1C are mirrors of $3F00/$3F04/$3F08/$3F0C
-        if (palette >= 0x10 && addr % 4 == 0)
-        {
-            palette = palette & 0xf;
-        }
-        m_palette[palette] = value;
+        // Palette from 0x3f00, mirrored every 0x20 upto 0x3fff
+        m_palette[PaletteMirror[addr & 0x1f]] = value;
     }
 }
 
 void PictureBus::updateMirroring()
 {
+    Byte* const lower  = &m_RAM[0];
+    Byte* const higher = &m_RAM[0x400];
     switch (m_mapper->getNameTableMirroring())
     {
     case Horizontal:
-        NameTable0 = NameTable1 = 0;
-        NameTable2 = NameTable3 = 0x400;
+        m_nameTables = { { lower, lower, higher, higher } };
         LOG(InfoVerbose) << "Horizontal Name Table mirroring set. (Vertical Scrolling)" << std::endl;
         break;
     case Vertical:
-        NameTable0 = NameTable2 = 0;
-        NameTable1 = NameTable3 = 0x400;
+        m_nameTables = { { lower, higher, lower, higher } };
         LOG(InfoVerbose) << "Vertical Name Table mirroring set. (Horizontal Scrolling)" << std::endl;
         break;
     case OneScreenLower:
-        NameTable0 = NameTable1 = NameTable2 = NameTable3 = 0;
+        m_nameTables = { { lower, lower, lower, lower } };
         LOG(InfoVerbose) << "Single Screen mirroring set with lower bank." << std::endl;
         break;
     case OneScreenHigher:
-        NameTable0 = NameTable1 = NameTable2 = NameTable3 = 0x400;
+        m_nameTables = { { higher, higher, higher, higher } };
         LOG(InfoVerbose) << "Single Screen mirroring set with higher bank." << std::endl;
         break;
     case FourScreen:
-        NameTable0 = m_RAM.size();
-        LOG(InfoVerbose) << "FourScreen mirroring." << std::endl;
+        if (Byte* cartridgeRAM = m_mapper->getNameTableRAM())
+        {
+            m_nameTables = { { cartridgeRAM, cartridgeRAM + 0x400, cartridgeRAM + 0x800, cartridgeRAM + 0xc00 } };
+            LOG(InfoVerbose) << "FourScreen mirroring." << std::endl;
+        }
+        else
+        {
+            m_nameTables = { { lower, lower, lower, lower } };
+            LOG(Error) << "FourScreen mirroring without name table memory on the cartridge" << std::endl;
+        }
         break;
     default:
-        NameTable0 = NameTable1 = NameTable2 = NameTable3 = 0;
+        m_nameTables = { { lower, lower, lower, lower } };
         LOG(Error) << "Unsupported Name Table mirroring : " << m_mapper->getNameTableMirroring() << std::endl;
     }
 }
@@ -146,6 +109,11 @@ bool PictureBus::setMapper(Mapper* mapper)
     return true;
 }
 
+void PictureBus::snapshot(Snapshot& state)
+{
+    state(m_nameTables, m_palette, m_RAM);
+}
+
 void PictureBus::scanlineIRQ()
 {
     m_mapper->scanlineIRQ();
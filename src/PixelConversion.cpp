@@ -0,0 +1,222 @@
+#include "PixelConversion.h"
+#include "PaletteColors.h"
+#include <array>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SN_SSE2
+#endif
+
+// SSSE3 and AVX2 are only compiled in where the compiler can target them per function, and are picked at runtime
+#if defined(SN_SSE2) && (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER))
+#define SN_SIMD
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SN_TARGET_SSSE3
+#define SN_TARGET_AVX2
+#else
+#define SN_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define SN_TARGET_AVX2  __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace sn
+{
+namespace
+{
+    // The 64 colors under each of the 8 combinations of emphasis bits
+    using EmphasisPalettes = std::array<std::uint32_t, 8 * 64>;
+
+    EmphasisPalettes makeEmphasisPalettes()
+    {
+        EmphasisPalettes palettes;
+        for (int emphasis = 0; emphasis < 8; ++emphasis)
+        {
+            for (int i = 0; i < 64; ++i)
+            {
+                std::uint8_t rgba[4] = { std::uint8_t(colors[i] >> 24),
+                                         std::uint8_t(colors[i] >> 16),
+                                         std::uint8_t(colors[i] >> 8),
+                                         std::uint8_t(colors[i]) };
+                // Emphasizing red, green or blue darkens the other two channels, so all three darken everything
+                for (int channel = 0; channel < 3; ++channel)
+                {
+                    if (emphasis & ~(1 << channel))
+                        rgba[channel] = rgba[channel] * 816 / 1000;
+                }
+                std::memcpy(&palettes[emphasis * 64 + i], rgba, sizeof(rgba));
+            }
+        }
+        return palettes;
+    }
+
+    const EmphasisPalettes emphasisPalettes = makeEmphasisPalettes();
+
+    // The same palettes split by byte: the R, G, B and A planes of the 64 colors, for 16-entry byte lookups
+    using EmphasisPlanes = std::array<std::array<std::uint8_t, 4 * 64>, 8>;
+
+    EmphasisPlanes makeEmphasisPlanes()
+    {
+        EmphasisPlanes planes;
+        for (int emphasis = 0; emphasis < 8; ++emphasis)
+        {
+            for (int i = 0; i < 64; ++i)
+            {
+                std::uint8_t rgba[4];
+                std::memcpy(rgba, &emphasisPalettes[emphasis * 64 + i], sizeof(rgba));
+                for (int plane = 0; plane < 4; ++plane)
+                    planes[emphasis][plane * 64 + i] = rgba[plane];
+            }
+        }
+        return planes;
+    }
+
+    const EmphasisPlanes emphasisPlanes = makeEmphasisPlanes();
+
+    // emphasis is the 3 emphasis bits, keep masks the indices
+    using Conversion = void (*)(const std::uint8_t*, int, std::uint8_t, std::uint32_t*, std::size_t);
+
+    void convertScalar(const std::uint8_t* indices,
+                       int                 emphasis,
+                       std::uint8_t        keep,
+                       std::uint32_t*      rgba,
+                       std::size_t         count)
+    {
+        const std::uint32_t* palette = &emphasisPalettes[emphasis * 64];
+        for (std::size_t i = 0; i < count; ++i)
+            rgba[i] = palette[indices[i] & keep];
+    }
+
+#ifdef SN_SIMD
+    // pshufb looks up 16 bytes in a 16-entry table at once, and gives 0 for the bytes whose index has bit 7 set.
+    // Each color plane is split into 4 tables of 16 entries: the index into a table has bit 7 set unless the high
+    // bits of the palette index select it, so ORing the 4 lookups gives the plane. Every color is opaque
+    SN_TARGET_SSSE3 void convertSSSE3(const std::uint8_t* indices,
+                                      int                 emphasis,
+                                      std::uint8_t        keep,
+                                      std::uint32_t*      rgba,
+                                      std::size_t         count)
+    {
+        const std::uint8_t* planes = emphasisPlanes[emphasis].data();
+        __m128i             tables[3][4];
+        for (int plane = 0; plane < 3; ++plane)
+        {
+            for (int table = 0; table < 4; ++table)
+            {
+                tables[plane][table] =
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(planes + plane * 64 + table * 16));
+            }
+        }
+        const __m128i keepMask = _mm_set1_epi8(static_cast<char>(keep));
+        // Pushes the indices of 16 and up into bit 7, while those below keep their low 4 bits
+        const __m128i outside  = _mm_set1_epi8(0x70);
+        const __m128i alpha    = _mm_set1_epi8(-1);
+
+        std::size_t   i        = 0;
+        for (; i + 16 <= count; i += 16)
+        {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i));
+            const __m128i index = _mm_and_si128(bytes, keepMask);
+            __m128i       tableIndex[4];
+            for (int table = 0; table < 4; ++table)
+            {
+                const __m128i base = _mm_set1_epi8(static_cast<char>(table * 16));
+                tableIndex[table]  = _mm_adds_epu8(_mm_xor_si128(index, base), outside);
+            }
+
+            __m128i channels[3];
+            for (int plane = 0; plane < 3; ++plane)
+            {
+                channels[plane] = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(tables[plane][0], tableIndex[0]),
+                                                            _mm_shuffle_epi8(tables[plane][1], tableIndex[1])),
+                                               _mm_or_si128(_mm_shuffle_epi8(tables[plane][2], tableIndex[2]),
+                                                            _mm_shuffle_epi8(tables[plane][3], tableIndex[3])));
+            }
+
+            const __m128i rgLow  = _mm_unpacklo_epi8(channels[0], channels[1]);
+            const __m128i rgHigh = _mm_unpackhi_epi8(channels[0], channels[1]);
+            const __m128i baLow  = _mm_unpacklo_epi8(channels[2], alpha);
+            const __m128i baHigh = _mm_unpackhi_epi8(channels[2], alpha);
+            __m128i*      out    = reinterpret_cast<__m128i*>(rgba + i);
+            _mm_storeu_si128(out, _mm_unpacklo_epi16(rgLow, baLow));
+            _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(rgLow, baLow));
+            _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(rgHigh, baHigh));
+            _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(rgHigh, baHigh));
+        }
+        convertScalar(indices + i, emphasis, keep, rgba + i, count - i);
+    }
+
+    // Widens 8 indices to 32 bits and gathers their colors in one instruction
+    SN_TARGET_AVX2 void convertAVX2(const std::uint8_t* indices,
+                                    int                 emphasis,
+                                    std::uint8_t        keep,
+                                    std::uint32_t*      rgba,
+                                    std::size_t         count)
+    {
+        const std::uint32_t* palette  = &emphasisPalettes[emphasis * 64];
+        const __m256i        keepMask = _mm256_set1_epi32(keep);
+
+        std::size_t   i        = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m128i bytes  = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(indices + i));
+            const __m256i index  = _mm256_and_si256(_mm256_cvtepu8_epi32(bytes), keepMask);
+            const __m256i pixels = _mm256_i32gather_epi32(reinterpret_cast<const int*>(palette), index, 4);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgba + i), pixels);
+        }
+        convertScalar(indices + i, emphasis, keep, rgba + i, count - i);
+    }
+
+    bool hasSSSE3()
+    {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 1);
+        return info[2] & (1 << 9);
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("ssse3");
+#endif
+    }
+
+    bool hasAVX2()
+    {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+        // The OS has to save the YMM registers too
+        __cpuid(info, 1);
+        if (!(info[2] & (1 << 27)) || (_xgetbv(0) & 0x6) != 0x6)
+            return false;
+        __cpuidex(info, 7, 0);
+        return info[1] & (1 << 5);
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif
+
+    Conversion selectConversion()
+    {
+#ifdef SN_SIMD
+        if (hasAVX2())
+            return convertAVX2;
+        if (hasSSSE3())
+            return convertSSSE3;
+#endif
+        return convertScalar;
+    }
+
+    const Conversion conversion = selectConversion();
+}
+
+void convertPixels(const std::uint8_t* indices, std::uint8_t mask, std::uint32_t* rgba, std::size_t count)
+{
+    // Greyscale only keeps the brightness of a color, the grey column of the palette
+    conversion(indices, mask >> 5, mask & 0x1 ? 0x30 : 0x3f, rgba, count);
+}
+}
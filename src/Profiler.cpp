@@ -0,0 +1,147 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace sn
+{
+namespace
+{
+    // The address, prefixed by its 8KB PRG-ROM bank for code in ROM
+    std::string locationName(std::uint32_t location, Address pc)
+    {
+        std::ostringstream name;
+        name << std::hex << std::uppercase << std::setfill('0');
+        if (location < 0x8000)
+            name << "   $" << std::setw(4) << pc;
+        else
+            name << std::setw(2) << ((location - 0x8000) >> 13) << ":$" << std::setw(4) << pc;
+        return name.str();
+    }
+
+    double percent(std::uint64_t part, std::uint64_t total)
+    {
+        return total ? 100.0 * part / total : 0.0;
+    }
+}
+
+Profiler::Profiler()
+{
+    reset(0);
+}
+
+void Profiler::reset(std::size_t prgSize)
+{
+    m_instructions.assign(0x8000 + prgSize, Counts());
+    m_routines.clear();
+    m_topLevel = Routine();
+    m_frames.clear();
+    m_cycles       = 0;
+    m_waitCycles   = 0;
+    m_nmiCount     = 0;
+    m_nmiCycles    = 0;
+    m_nmiMaxCycles = 0;
+}
+
+void Profiler::instruction(std::uint32_t location, Address pc, int cycles)
+{
+    auto& counts       = m_instructions[location];
+    counts.executions += 1;
+    counts.cycles     += cycles;
+    counts.pc          = pc;
+
+    (m_frames.empty() ? m_topLevel : *m_frames.back().routine).selfCycles += cycles;
+    m_cycles                                                               += cycles;
+}
+
+void Profiler::enter(std::uint32_t routine, Address pc, std::uint64_t cycle, Byte sp, bool nmi)
+{
+    // Code that never returns would pile up frames, only the innermost calls matter then
+    if (m_frames.size() == 0x100)
+        m_frames.erase(m_frames.begin());
+
+    auto& entry  = m_routines[routine];
+    entry.calls += 1;
+    entry.pc     = pc;
+    m_frames.push_back({ &entry, cycle, sp, nmi });
+}
+
+void Profiler::leave(std::uint64_t cycle, Byte sp)
+{
+    // Comparing stack pointers also unwinds routines left by pulling their return address off the stack
+    while (!m_frames.empty() && m_frames.back().sp <= sp)
+    {
+        const auto& frame                = m_frames.back();
+        frame.routine->inclusiveCycles  += cycle - frame.start;
+        if (frame.nmi)
+        {
+            m_nmiCount     += 1;
+            m_nmiCycles    += cycle - frame.start;
+            m_nmiMaxCycles  = std::max(m_nmiMaxCycles, cycle - frame.start);
+        }
+        m_frames.pop_back();
+    }
+}
+
+void Profiler::waitLoop(std::uint64_t cycles, bool skipped)
+{
+    m_waitCycles += cycles;
+    if (skipped)
+    {
+        (m_frames.empty() ? m_topLevel : *m_frames.back().routine).selfCycles += cycles;
+        m_cycles                                                               += cycles;
+    }
+}
+
+void Profiler::report(std::ostream& out, std::size_t lines) const
+{
+    out << std::fixed << std::setprecision(2);
+    out << "Cycles: " << m_cycles << "\n"
+        << "Wait loops: " << m_waitCycles << " cycles, " << percent(m_waitCycles, m_cycles) << "%\n"
+        << "NMI handler: " << m_nmiCount << " runs, " << (m_nmiCount ? m_nmiCycles / m_nmiCount : 0)
+        << " cycles per frame, at most " << m_nmiMaxCycles << ", " << percent(m_nmiCycles, m_cycles) << "%\n\n";
+
+    std::vector<std::pair<std::uint32_t, const Routine*>> routines;
+    routines.emplace_back(UINT32_MAX, &m_topLevel);
+    for (const auto& routine : m_routines)
+        routines.emplace_back(routine.first, &routine.second);
+    std::sort(routines.begin(),
+              routines.end(),
+              [](const std::pair<std::uint32_t, const Routine*>& a, const std::pair<std::uint32_t, const Routine*>& b)
+              { return a.second->selfCycles > b.second->selfCycles; });
+
+    out << "Hottest routines\n"
+        << "   Routine      Self cycles       %       Incl. cycles       Calls\n";
+    for (std::size_t i = 0; i < std::min(lines, routines.size()); ++i)
+    {
+        const auto& routine = *routines[i].second;
+        out << std::setw(12)
+            << (routines[i].first == UINT32_MAX ? std::string("top level") : locationName(routines[i].first, routine.pc))
+            << std::setw(17) << routine.selfCycles << std::setw(8) << percent(routine.selfCycles, m_cycles)
+            << std::setw(19) << routine.inclusiveCycles << std::setw(12) << routine.calls << "\n";
+    }
+
+    std::vector<std::uint32_t> instructions;
+    for (std::uint32_t location = 0; location < m_instructions.size(); ++location)
+    {
+        if (m_instructions[location].executions)
+            instructions.push_back(location);
+    }
+    const auto count = std::min(lines, instructions.size());
+    std::partial_sort(instructions.begin(),
+                      instructions.begin() + count,
+                      instructions.end(),
+                      [&](std::uint32_t a, std::uint32_t b)
+                      { return m_instructions[a].cycles > m_instructions[b].cycles; });
+
+    out << "\nHottest instructions\n"
+        << "   Address           Cycles       %         Executions\n";
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const auto& counts = m_instructions[instructions[i]];
+        out << std::setw(12) << locationName(instructions[i], counts.pc) << std::setw(17) << counts.cycles
+            << std::setw(8) << percent(counts.cycles, m_cycles) << std::setw(19) << counts.executions << "\n";
+    }
+    out << std::flush;
+}
+}
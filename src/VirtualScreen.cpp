@@ -1,81 +1,51 @@
 #include "VirtualScreen.h"
+#include "PixelConversion.h"
+#include <cstring>
 
 namespace sn
 {
 void VirtualScreen::create(unsigned int w, unsigned int h, float pixel_size, sf::Color color)
 {
-    m_vertices.resize(w * h * 6);
     m_screenSize = { w, h };
-    m_vertices.setPrimitiveType(sf::Triangles);
-    m_pixelSize = pixel_size;
-    for (std::size_t x = 0; x < w; ++x)
-    {
-        for (std::size_t y = 0; y < h; ++y)
-        {
-            auto         index = (x * m_screenSize.y + y) * 6;
-            sf::Vector2f coord2d(x * m_pixelSize, y * m_pixelSize);
 
-            // Triangle-1
-            // top-left
-            m_vertices[index].position     = coord2d;
-            m_vertices[index].color        = color;
-
-            // top-right
-            m_vertices[index + 1].position = coord2d + sf::Vector2f { m_pixelSize, 0 };
-            m_vertices[index + 1].color    = color;
-
-            // bottom-right
-            m_vertices[index + 2].position = coord2d + sf::Vector2f { m_pixelSize, m_pixelSize };
-            m_vertices[index + 2].color    = color;
-
-            // Triangle-2
-            // bottom-right
-            m_vertices[index + 3].position = coord2d + sf::Vector2f { m_pixelSize, m_pixelSize };
-            m_vertices[index + 3].color    = color;
-
-            // bottom-left
-            m_vertices[index + 4].position = coord2d + sf::Vector2f { 0, m_pixelSize };
-            m_vertices[index + 4].color    = color;
-
-            // top-left
-            m_vertices[index + 5].position = coord2d;
-            m_vertices[index + 5].color    = color;
-        }
-    }
+    sf::Uint8     rgba[4] = { color.r, color.g, color.b, color.a };
+    std::uint32_t pixel;
+    std::memcpy(&pixel, rgba, sizeof(pixel));
+    for (auto& buffer : m_buffers)
+        buffer.assign(w * h, pixel);
+    m_writeBuffer = 0;
+    m_readyBuffer = 1;
+    m_readBuffer  = 2;
+
+    m_texture.create(w, h);
+    m_texture.update(reinterpret_cast<const sf::Uint8*>(m_buffers[m_readBuffer].data()));
+    m_sprite.setTexture(m_texture, true);
+    m_sprite.setScale(pixel_size, pixel_size);
 }
 
-void VirtualScreen::setPixel(std::size_t x, std::size_t y, sf::Color color)
+void VirtualScreen::setFrame(const std::uint8_t* indices, const std::uint8_t* lineMasks)
 {
-    auto index = (x * m_screenSize.y + y) * 6;
-    if (index >= m_vertices.getVertexCount())
-        return;
-
-    sf::Vector2f coord2d(x * m_pixelSize, y * m_pixelSize);
+    auto& pixels = m_buffers[m_writeBuffer];
+    for (std::size_t y = 0; y < m_screenSize.y; ++y)
+        convertPixels(indices + y * m_screenSize.x, lineMasks[y], &pixels[y * m_screenSize.x], m_screenSize.x);
 
-    // Triangle-1
-    // top-left
-    m_vertices[index].color     = color;
-
-    // top-right
-    m_vertices[index + 1].color = color;
-
-    // bottom-right
-    m_vertices[index + 2].color = color;
-
-    // Triangle-2
-    // bottom-right
-    m_vertices[index + 3].color = color;
+    // Publishes the frame, a ready one that wasn't taken yet is written over next
+    m_writeBuffer = m_readyBuffer.exchange(m_writeBuffer | NewFrame, std::memory_order_acq_rel) & ~NewFrame;
+}
 
-    // bottom-left
-    m_vertices[index + 4].color = color;
+bool VirtualScreen::update()
+{
+    if (!(m_readyBuffer.load(std::memory_order_relaxed) & NewFrame))
+        return false;
 
-    // top-left
-    m_vertices[index + 5].color = color;
+    m_readBuffer = m_readyBuffer.exchange(m_readBuffer, std::memory_order_acq_rel) & ~NewFrame;
+    m_texture.update(reinterpret_cast<const sf::Uint8*>(m_buffers[m_readBuffer].data()));
+    return true;
 }
 
 void VirtualScreen::draw(sf::RenderTarget& target, sf::RenderStates states) const
 {
-    target.draw(m_vertices, states);
+    target.draw(m_sprite, states);
 }
 
-}
\ No newline at end of file
+}
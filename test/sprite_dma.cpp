@@ -0,0 +1,109 @@
+#include "Cartridge.h"
+#include "IRQ.h"
+#include "Log.h"
+#include "Mapper.h"
+#include "PPU.h"
+#include "PictureBus.h"
+#include "VirtualScreen.h"
+
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+// Regression test: sprites are picked for a line at the end of the line before it, and a program may DMA a new
+// page to OAM before that line is drawn. Hidden sprites (Y=$F0) using tile 0 of the low pattern table then sit
+// below the line, and their row offset used to wrap the pattern row address to 0xfffx, past the CHR windows.
+// As on hardware, the line is drawn with the sprites as they were when picked.
+
+using namespace sn;
+
+class NullIRQ : public IRQHandle
+{
+public:
+    void pull() override {}
+    void release() override {}
+};
+
+// A 16KB PRG, 8KB CHR NROM image with a solid tile 0
+static bool writeROM(const char* path)
+{
+    std::vector<Byte> rom(0x10 + 0x4000 + 0x2000);
+    rom[0] = 'N', rom[1] = 'E', rom[2] = 'S', rom[3] = 0x1a;
+    rom[4] = 1, rom[5] = 1;
+    for (int i = 0; i < 8; ++i)
+        rom[0x10 + 0x4000 + i] = 0xff;
+
+    std::ofstream file(path, std::ios_base::binary);
+    return bool(file.write(reinterpret_cast<const char*>(rom.data()), rom.size()));
+}
+
+int main()
+{
+    Log::get().setLogStream(std::cerr);
+    Log::get().setLevel(Error);
+
+    const char* path = "sprite_dma.nes";
+    Cartridge   cartridge;
+    if (!writeROM(path) || !cartridge.loadFromFile(path))
+    {
+        std::printf("FAIL: couldn't load the test ROM\n");
+        return 1;
+    }
+
+    NullIRQ       irq;
+    PictureBus    bus;
+    VirtualScreen screen;
+    PPU           ppu(bus, screen);
+    auto mapper = Mapper::createMapper(Mapper::NROM, cartridge, irq, [&]() { bus.updateMirroring(); });
+    if (!mapper || !bus.setMapper(mapper.get()))
+    {
+        std::printf("FAIL: couldn't set up the mapper\n");
+        return 1;
+    }
+
+    int failures = 0;
+
+    // Addresses past the pattern tables wrap around them, rows past the tile's last one within it
+    if (mapper->getPatternRow(0xfff9) != mapper->getPatternRow(0x1ff1) ||
+        mapper->getPatternRow(0xf000) != mapper->getPatternRow(0x1000))
+    {
+        std::printf("FAIL: pattern row addresses don't wrap\n");
+        ++failures;
+    }
+
+    ppu.reset();
+    ppu.setInterruptCallback([]() {});
+    ppu.control(0);     // 8x8 sprites from the low pattern table
+    ppu.setMask(0x1e);  // Background and sprites, edges included
+
+    // Every sprite on lines 10 to 17, from x 200 on
+    std::array<Byte, 0x100> page {};
+    for (int i = 0; i < 64; ++i)
+        page[i * 4] = 9, page[i * 4 + 3] = 200;
+    ppu.doDMA(page.data());
+
+    // Through the pre-render line and the first ten lines, which picks the sprites for line 10, and a few dots in
+    ppu.step(11 * ScanlineCycleLength);
+
+    // Hide them all before the line reaches them, then draw on, whole lines at once and dot by dot
+    for (int i = 0; i < 64; ++i)
+        page[i * 4] = 0xf0;
+    ppu.doDMA(page.data());
+    ppu.step(ScanlineCycleLength);
+    for (int dot = 0; dot < ScanlineCycleLength; ++dot)
+        ppu.step();
+
+    // Sprite 0 still hit the background, made of the solid tile 0, on line 10
+    if (!(ppu.getStatus() & 0x40))
+    {
+        std::printf("FAIL: sprites written to after they were picked weren't drawn\n");
+        ++failures;
+    }
+
+    if (failures)
+        return 1;
+    std::printf("OK\n");
+    return 0;
+}
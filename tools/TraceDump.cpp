@@ -0,0 +1,46 @@
+// Converts a binary CPU trace recorded with --trace-cpu to the text log of --log-cpu
+#include "CPUTrace.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+    if (argc != 2)
+    {
+        std::cout << "Usage: SimpleNES-tracedump trace-path > log-path" << std::endl;
+        return 1;
+    }
+
+    std::ifstream file(argv[1], std::ios::binary);
+    if (!file)
+    {
+        std::cerr << "Could not open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    sn::CPUTraceHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, sn::CPUTraceMagic, sizeof(header.magic)) != 0 ||
+        header.recordSize != sizeof(sn::CPUTraceRecord) || header.capacity == 0)
+    {
+        std::cerr << argv[1] << " is not a CPU trace of this version" << std::endl;
+        return 1;
+    }
+
+    // Once the ring wrapped around, the oldest record is the one that would be overwritten next
+    std::vector<sn::CPUTraceRecord> records(header.written < header.capacity ? header.written : header.capacity);
+    if (!file.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(sn::CPUTraceRecord)))
+    {
+        std::cerr << argv[1] << " is truncated" << std::endl;
+        return 1;
+    }
+
+    const std::size_t oldest = header.written < header.capacity ? 0 : header.written % header.capacity;
+    for (std::size_t i = 0; i < records.size(); ++i)
+    {
+        std::cout << records[(oldest + i) % records.size()] << '\n';
+    }
+    return 0;
+}